@@ -1,5 +1,5 @@
 #include "bespiral.community.hpp"
-#include "../utils/utils.cpp"
+#include "../utils/utils.hpp"
 
 void bespiral::create(eosio::asset cmm_asset, eosio::name creator, std::string logo,
                       std::string name, std::string description,
@@ -31,11 +31,11 @@ void bespiral::create(eosio::asset cmm_asset, eosio::name creator, std::string l
     r.symbol = new_symbol;
 
     r.creator = creator;
-    r.logo = logo;
     r.name = name;
-    r.description = description;
     r.inviter_reward = inviter_reward;
     r.invited_reward = invited_reward;
+    set_shared_text(r.logo, r.logo_handle, logo);
+    set_text(r.description, r.description_handle, description);
   });
 
   SEND_INLINE_ACTION(*this,                            // Account
@@ -61,15 +61,17 @@ void bespiral::update(eosio::asset cmm_asset, std::string logo, std::string name
   eosio_assert(description.size() <= 256, "description has more than 256 bytes");
 
   community.modify(cmm, _self, [&](auto &row) {
-    row.logo = logo;
     row.name = name;
-    row.description = description;
     row.inviter_reward = inviter_reward;
     row.invited_reward = invited_reward;
+    set_shared_text(row.logo, row.logo_handle, logo);
+    set_text(row.description, row.description_handle, description);
   });
 }
 
 void bespiral::netlink(eosio::asset cmm_asset, eosio::name inviter, eosio::name new_user) {
+  BES_TRACE_ACTION("netlink");
+
   eosio_assert(is_account(new_user), "new user account doesn't exists");
 
   // Check for inviter auth, otherwise check for backend's auth
@@ -93,18 +95,38 @@ void bespiral::netlink(eosio::asset cmm_asset, eosio::name inviter, eosio::name
     return; // Skip if user already in the network
 
   // Validates inviter if not the creator
+  auto inviter_id = gen_uuid(cmm.symbol.raw(), inviter.value);
+  auto itr_inviter = network.find(inviter_id);
   if (cmm.creator != inviter) {
-    auto inviter_id = gen_uuid(cmm.symbol.raw(), inviter.value);
-    auto itr_inviter = network.find(inviter_id);
     eosio_assert(itr_inviter != network.end(), "unknown inviter");
   }
 
+  // Inviters of the new user, nearest first
+  std::vector<eosio::name> ancestors;
+  if (inviter != new_user) {
+    ancestors.push_back(inviter);
+    if (itr_inviter != network.end()) {
+      for (auto &ancestor : network_ancestors(*itr_inviter)) {
+        if (ancestors.size() == max_referral_depth) break;
+        ancestors.push_back(ancestor);
+      }
+    }
+  }
+
   network.emplace(_self, [&](auto &r) {
     r.id = id;
     r.community = cmm_symbol;
     r.invited_user = new_user;
     r.invited_by = inviter;
+    r.subtree_size.emplace(0);
+    r.ancestors.emplace(ancestors);
+    r.is_indexed.emplace(1);
   });
+  BES_COUNT(rows_written);
+
+  count_in_ancestors(cmm_symbol, ancestors);
+
+  update_aggregate(cmm_symbol, [&](auto &a) { a.members++; });
 
   // Notify user
   require_recipient(new_user);
@@ -123,9 +145,29 @@ void bespiral::netlink(eosio::asset cmm_asset, eosio::name inviter, eosio::name
                                                  // to, quantity, memo
                                                  std::make_tuple(inviter, cmm.inviter_reward, memo_inviter));
     inviter_reward.send();
+    BES_COUNT(inline_sends);
     require_recipient(inviter);
   }
 
+  // Inviters above the direct one get a share of the inviter reward
+  referral_configs referral(_self, _self.value);
+  auto itr_referral = ancestors.size() > 1 ? referral.find(cmm_symbol.raw()) : referral.end();
+  if (cmm.inviter_reward.amount > 0 && itr_referral != referral.end()) {
+    std::string memo_referral = "Thanks for helping " + cmm.name + " grow!";
+    const auto &level_rates = itr_referral->level_rates;
+    for (std::size_t level = 1; level < ancestors.size() && level <= level_rates.size(); level++) {
+      eosio::asset referral_reward = cmm.inviter_reward * level_rates[level - 1] / 10000;
+      if (referral_reward.amount == 0) continue;
+
+      eosio::action(eosio::permission_level{currency_account, eosio::name{"active"}}, // Permission
+                    currency_account,                                                 // Account
+                    eosio::name{"issue"},                                             // Action
+                    // to, quantity, memo
+                    std::make_tuple(ancestors[level], referral_reward, memo_referral)).send();
+      BES_COUNT(inline_sends);
+    }
+  }
+
   // Send invited reward
   if (cmm.invited_reward.amount > 0) {
     std::string memo_invited = "Welcome to " + cmm.name + "!";
@@ -135,6 +177,7 @@ void bespiral::netlink(eosio::asset cmm_asset, eosio::name inviter, eosio::name
                                                  // to, quantity, memo
                                                  std::make_tuple(new_user, cmm.invited_reward, memo_invited));
     invited_reward.send();
+    BES_COUNT(inline_sends);
     require_recipient(new_user);
   } else {
     eosio::action init_account = eosio::action(eosio::permission_level{currency_account, eosio::name{"active"}}, // Permission
@@ -142,6 +185,109 @@ void bespiral::netlink(eosio::asset cmm_asset, eosio::name inviter, eosio::name
                                                eosio::name{"initacc"},                                           // Action
                                                std::make_tuple(cmm.invited_reward.symbol, new_user));
     init_account.send();
+    BES_COUNT(inline_sends);
+  }
+}
+
+/*
+  Inviters of a member, nearest first. Rows written before referral paths existed are not indexed
+  yet, so their inviters are followed instead, up to `max_referral_depth` levels.
+ */
+std::vector<eosio::name> bespiral::network_ancestors(const bespiral::network &member) {
+  if (member.has_ancestors()) return member.ancestors.value();
+
+  networks network(_self, _self.value);
+  std::vector<eosio::name> ancestors;
+  const bespiral::network *current = &member;
+  while (ancestors.size() < max_referral_depth && current->invited_by != current->invited_user) {
+    ancestors.push_back(current->invited_by);
+
+    auto itr = network.find(gen_uuid(member.community.raw(), current->invited_by.value));
+    if (itr == network.end()) break;
+
+    // The rest of the path is already on the inviter's row
+    if (itr->has_ancestors()) {
+      for (auto &ancestor : itr->ancestors.value()) {
+        if (ancestors.size() == max_referral_depth) break;
+        ancestors.push_back(ancestor);
+      }
+      break;
+    }
+    current = &*itr;
+  }
+
+  return ancestors;
+}
+
+void bespiral::count_in_ancestors(eosio::symbol community_symbol, const std::vector<eosio::name> &ancestors) {
+  networks network(_self, _self.value);
+  for (auto &ancestor : ancestors) {
+    auto itr = network.find(gen_uuid(community_symbol.raw(), ancestor.value));
+    if (itr == network.end()) continue;
+
+    network.modify(itr, _self, [&](auto &n) { n.subtree_size.emplace(n.subtree_size.value_or(0) + 1); });
+    BES_COUNT(rows_written);
+  }
+}
+
+/*
+  Network rows written before referral paths existed get their ancestors here, and are counted
+  on the subtree of each of them. Indexed rows were counted when written.
+ */
+jobs::slice bespiral::index_network(std::uint64_t from_id, std::uint64_t max_rows) {
+  jobs::slice result{from_id, 0, false};
+
+  networks network(_self, _self.value);
+  auto itr = network.lower_bound(from_id);
+  for (; itr != network.end() && result.rows < max_rows; itr++, result.rows++) {
+    result.cursor = itr->id + 1;
+    if (itr->has_ancestors()) continue;
+
+    auto ancestors = network_ancestors(*itr);
+    network.modify(itr, _self, [&](auto &n) {
+                                 if (!n.subtree_size.has_value()) n.subtree_size.emplace(0);
+                                 n.ancestors.emplace(ancestors);
+                                 n.is_indexed.emplace(1);
+                               });
+    count_in_ancestors(itr->community, ancestors);
+  }
+
+  result.done = itr == network.end();
+  return result;
+}
+
+/**
+   Configure multi-level referral rewards.
+   @version 1.0
+
+   On every netlink the direct inviter gets the community inviter reward. The inviter above it gets
+   `level_rates[0]` basis points of that reward, the next one `level_rates[1]` and so on, up to
+   `max_referral_depth` levels. An empty list turns them off.
+*/
+void bespiral::setreferral(eosio::symbol community_symbol, std::vector<std::uint16_t> level_rates) {
+  communities community(_self, _self.value);
+  const auto &cmm = community.get(community_symbol.raw(), "can't find any community with given symbol");
+  require_auth(cmm.creator);
+
+  eosio_assert(level_rates.size() < max_referral_depth, "Too many referral levels");
+  for (auto rate : level_rates) {
+    eosio_assert(rate <= 10000, "Referral rates are basis points, they can't be over 10000");
+  }
+
+  referral_configs referral(_self, _self.value);
+  auto itr = referral.find(community_symbol.raw());
+  if (level_rates.empty()) {
+    if (itr != referral.end()) referral.erase(itr);
+    return;
+  }
+
+  if (itr == referral.end()) {
+    referral.emplace(_self, [&](auto &r) {
+                              r.community = community_symbol;
+                              r.level_rates = level_rates;
+                            });
+  } else {
+    referral.modify(itr, _self, [&](auto &r) { r.level_rates = level_rates; });
   }
 }
 
@@ -166,10 +312,12 @@ void bespiral::newobjective(eosio::asset cmm_asset, std::string description, eos
   objectives objective(_self, _self.value);
   objective.emplace(_self, [&](auto &o) {
                              o.id = get_available_id("objectives");
-                             o.description = description;
                              o.community = community_symbol;
                              o.creator = creator;
+                             set_text(o.description, o.description_handle, description);
                            });
+
+  update_aggregate(community_symbol, [&](auto &a) { a.objectives++; });
 }
 
 void bespiral::updobjective(std::uint64_t objective_id, std::string description, eosio::name editor) {
@@ -195,7 +343,7 @@ void bespiral::updobjective(std::uint64_t objective_id, std::string description,
   eosio_assert(found_objective.creator == editor || cmm.creator == editor, "You must be either the creator of the objective or the community creator to edit");
 
   objective.modify(found_objective, _self, [&](auto &row) {
-                                             row.description = description;
+                                             set_text(row.description, row.description_handle, description);
                                            });
 }
 
@@ -205,7 +353,10 @@ void bespiral::upsertaction(std::uint64_t action_id, std::uint64_t objective_id,
                             std::uint64_t usages, std::uint64_t usages_left,
                             std::uint64_t verifications, std::string verification_type,
                             std::string validators_str, std::uint8_t is_completed,
-                            eosio::name creator) {
+                            eosio::name creator,
+                            eosio::binary_extension<std::uint64_t> max_open_claims) {
+  BES_TRACE_ACTION("upsertaction");
+
   // Validate creator
   eosio_assert(is_account(creator), "invalid account for creator");
   require_auth(creator);
@@ -268,10 +419,9 @@ void bespiral::upsertaction(std::uint64_t action_id, std::uint64_t objective_id,
     // Get last used action id and update table_index table
     action_id = get_available_id("actions");
 
-    action.emplace(_self, [&](auto &a) {
+    itr_act = action.emplace(_self, [&](auto &a) {
                             a.id = action_id;
                             a.objective_id = objective_id;
-                            a.description = description;
                             a.reward = reward;
                             a.verifier_reward = verifier_reward;
                             a.deadline = deadline;
@@ -281,10 +431,13 @@ void bespiral::upsertaction(std::uint64_t action_id, std::uint64_t objective_id,
                             a.verification_type = verification_type;
                             a.is_completed = 0;
                             a.creator = creator;
+                            set_text(a.description, a.description_handle, description);
+                            a.max_open_claims.emplace(max_open_claims.value_or(0));
                           });
+    BES_COUNT(rows_written);
   } else {
     action.modify(itr_act, _self, [&](auto& a) {
-                                    a.description = description;
+                                    set_text(a.description, a.description_handle, description);
                                     a.reward = reward;
                                     a.verifier_reward = verifier_reward;
                                     a.deadline = deadline;
@@ -292,16 +445,24 @@ void bespiral::upsertaction(std::uint64_t action_id, std::uint64_t objective_id,
                                     a.usages_left = usages_left;
                                     a.verifications = verifications;
                                     a.verification_type = verification_type;
-                                    a.is_completed = is_completed;
+                                    // An action without usages left can't be claimed anymore
+                                    a.is_completed = is_completed || (usages > 0 && usages_left == 0);
+
+                                    // Callers that don't know about the limit keep the current one
+                                    if (max_open_claims.has_value()) a.max_open_claims.emplace(max_open_claims.value());
                                   });
+    BES_COUNT(rows_written);
   }
 
+  sync_active_action(*itr_act, obj.community);
+
   if (verification_type == "claimable") {
-    // Validate list of validators
-    std::vector<std::string> strs = split(validators_str, "-");
-    eosio_assert(strs.size() >= verifications, "You cannot have a bigger number of verifications than accounts in the validator list");
+    // Validate list of validators, its items are views into validators_str
+    std::vector<std::string_view> validator_v = split(validators_str, "-");
+    eosio_assert(validator_v.size() >= verifications, "You cannot have a bigger number of verifications than accounts in the validator list");
 
     // Ensure list of validators in unique
+    std::vector<std::string_view> strs = validator_v;
     sort(strs.begin(), strs.end());
     auto strs_it = std::unique(strs.begin(), strs.end());
     eosio_assert(strs_it == strs.end(), "You cannot add a validator more than once to an action");
@@ -316,14 +477,15 @@ void bespiral::upsertaction(std::uint64_t action_id, std::uint64_t objective_id,
 
     // for (validator;itr_vals != validator.end();) {
     for (auto itr_vals = validator.begin();itr_vals != validator.end();) {
-      eosio::print_f("Test Table : {%, %}\n", itr_vals->action_id);
+      BES_LOG_DEBUG("Removing validator % from action %\n", itr_vals->validator, itr_vals->action_id);
+      BES_COUNT(rows_written);
       itr_vals = validator.erase(itr_vals);
     }
 
-    std::vector<std::string> validator_v = split(validators_str, "-");
     for (auto i : validator_v) {
+      eosio_assert(!i.empty(), "account from validator list cannot be empty");
+      eosio_assert(is_valid_name(i), "account from validator list isn't a valid name");
       eosio::name acc = eosio::name{i};
-      eosio_assert((bool)acc, "account from validator list cannot be empty");
       eosio_assert(is_account(acc), "account from validator list don't exist");
 
       // Must belong to the community
@@ -337,6 +499,7 @@ void bespiral::upsertaction(std::uint64_t action_id, std::uint64_t objective_id,
                                  v.action_id = action_id;
                                  v.validator = acc;
                                });
+      BES_COUNT(rows_written);
     };
   }
 }
@@ -391,6 +554,7 @@ void bespiral::verifyaction(std::uint64_t action_id, eosio::name maker, eosio::n
                                        a.is_completed = 1;
                                      }
                                    });
+  sync_active_action(*itr_objact, cmm.symbol);
 
   // Find Token
   // bespiral_tokens tokens(currency_account, currency_account.value);
@@ -414,6 +578,8 @@ void bespiral::verifyaction(std::uint64_t action_id, eosio::name maker, eosio::n
 /// @abi action
 /// Start a new claim on an action
 void bespiral::claimaction(std::uint64_t action_id, eosio::name maker) {
+  BES_TRACE_ACTION("claimaction");
+
   // Validate maker
   eosio_assert(is_account(maker), "invalid account for maker");
   require_auth(maker);
@@ -454,6 +620,17 @@ void bespiral::claimaction(std::uint64_t action_id, eosio::name maker) {
   eosio_assert(itr_network != network.end(), "Maker doesn't belong to the community");
 
 
+  // Limit the open claims of the maker on this action, counted so it takes a single lookup
+  std::uint64_t max_open_claims = objact.max_open_claims.value_or(0);
+  if (max_open_claims > 0) {
+    open_claim_counts open_count(_self, maker.value);
+    auto itr_open = open_count.find(action_id);
+    eosio_assert(itr_open == open_count.end() || itr_open->open < max_open_claims,
+                 "Maker has reached the limit of open claims for this action");
+  }
+
+  throttle_claims(maker);
+
   // Get last used claim id and update item_index table
   uint64_t claim_id;
   claim_id = get_available_id("claims");
@@ -466,19 +643,66 @@ void bespiral::claimaction(std::uint64_t action_id, eosio::name maker) {
                          c.claimer = maker;
                          c.is_verified = 0;
                        });
+  BES_COUNT(rows_written);
+
+  add_open_claim(maker, action_id);
+  update_aggregate(cmm.symbol, [&](auto &a) { a.open_claims++; });
+}
+
+/**
+   Configure the claim throttle.
+   @version 1.0
+
+   Each user can open at most `max_claims` claims in any `window` seconds, counted with a sliding
+   window over the current and previous fixed windows. A `window` of 0 turns the throttle off.
+*/
+void bespiral::setthrottle(std::uint32_t window, std::uint32_t max_claims) {
+  require_auth(_self);
+
+  eosio_assert(window == 0 || max_claims > 0, "max_claims must be greater than 0");
+
+  throttle_configs config(_self, _self.value);
+  config.set(throttle_config{window, max_claims}, _self);
 }
 
 /// @abi action
 /// Send a positive verification for a given claim
 void bespiral::verifyclaim(std::uint64_t claim_id, eosio::name verifier, std::uint8_t vote) {
+  BES_TRACE_ACTION("verifyclaim");
+
+  require_auth(verifier);
+
+  vote_batch batch;
+  apply_vote(claim_id, verifier, vote, batch);
+  send_verifier_rewards(verifier, batch);
+}
+
+/// @abi action
+/// Send the votes of a review session, in order, as a single transaction
+void bespiral::verifyclaims(eosio::name verifier, std::vector<claim_vote> votes) {
+  BES_TRACE_ACTION("verifyclaims");
+
+  require_auth(verifier);
+
+  eosio_assert(!votes.empty(), "There must be at least one vote");
+
+  vote_batch batch;
+  for (const auto &v : votes) {
+    apply_vote(v.claim_id, verifier, v.vote, batch);
+  }
+  send_verifier_rewards(verifier, batch);
+}
+
+void bespiral::apply_vote(std::uint64_t claim_id, eosio::name verifier, std::uint8_t vote, vote_batch &batch) {
   // Validates verifier belongs to the action community
   claims claim_table(_self, _self.value);
   auto itr_clm = claim_table.find(claim_id);
   eosio_assert(itr_clm != claim_table.end(), "Can't find claim with given claim_id");
   auto &claim = *itr_clm;
 
-  // Check if claim is already verified
-  eosio_assert(claim.is_verified == false, "Can't approve already verified claim");
+  // Check if claim is already verified or rejected
+  eosio_assert(claim.is_verified != 1, "Can't approve already verified claim");
+  eosio_assert(!claim.was_rejected(), "Claim was rejected, it can't get enough positive votes anymore");
 
   // Validates if action exists
   actions action(_self, _self.value);
@@ -486,32 +710,40 @@ void bespiral::verifyclaim(std::uint64_t claim_id, eosio::name verifier, std::ui
   eosio_assert(itr_objact != action.end(), "Can't find action with given claim_id");
   auto &objact = *itr_objact;
 
-  // Check if user belongs to the action_validator list
-  validators validator(_self, objact.id);
-  std::uint64_t validator_count = 0;
-  for (auto itr_validators = validator.begin(); itr_validators != validator.end();) {
-    if ((*itr_validators).validator == verifier) {
-      validator_count++;
+  // The validator list and the community only depend on the action, check them once per batch
+  eosio::symbol community_symbol;
+  auto itr_checked = batch.action_communities.find(objact.id);
+  if (itr_checked != batch.action_communities.end()) {
+    community_symbol = itr_checked->second;
+  } else {
+    // Check if user belongs to the action_validator list
+    validators validator(_self, objact.id);
+    bool is_validator = false;
+    for (auto itr_validators = validator.begin(); itr_validators != validator.end() && !is_validator; itr_validators++) {
+      BES_COUNT(rows_read);
+      is_validator = itr_validators->validator == verifier;
     }
-    itr_validators++;
+    eosio_assert(is_validator, "Verifier is not in the action validator list");
+
+    // Check if verifier belongs to the community
+    objectives objective(_self, _self.value);
+    auto itr_obj = objective.find(objact.objective_id);
+    eosio_assert(itr_obj != objective.end(), "Can't find objective with given claim_id");
+    auto &obj = *itr_obj;
+
+    communities community(_self, _self.value);
+    auto itr_cmm = community.find(obj.community.raw());
+    eosio_assert(itr_cmm != community.end(), "Can't find community with given claim_id");
+    auto &cmm = *itr_cmm;
+
+    networks network(_self, _self.value);
+    auto verifier_id = gen_uuid(cmm.symbol.raw(), verifier.value);
+    auto itr_network = network.find(verifier_id);
+    eosio_assert(itr_network != network.end(), "Verifier doesn't belong to the community");
+
+    community_symbol = cmm.symbol;
+    batch.action_communities[objact.id] = community_symbol;
   }
-  eosio_assert(validator_count > 0, "Verifier is not in the action validator list");
-
-  // Check if verifier belongs to the community
-  objectives objective(_self, _self.value);
-  auto itr_obj = objective.find(objact.objective_id);
-  eosio_assert(itr_obj != objective.end(), "Can't find objective with given claim_id");
-  auto &obj = *itr_obj;
-
-  communities community(_self, _self.value);
-  auto itr_cmm = community.find(obj.community.raw());
-  eosio_assert(itr_cmm != community.end(), "Can't find community with given claim_id");
-  auto &cmm = *itr_cmm;
-
-  networks network(_self, _self.value);
-  auto verifier_id = gen_uuid(cmm.symbol.raw(), verifier.value);
-  auto itr_network = network.find(verifier_id);
-  eosio_assert(itr_network != network.end(), "Verifier doesn't belong to the community");
 
   // Check if action is completed, have usages left or the deadline has been met
   eosio_assert(objact.is_completed == false, "This is action is already completed, can't verify claim");
@@ -526,15 +758,20 @@ void bespiral::verifyclaim(std::uint64_t claim_id, eosio::name verifier, std::ui
 
   // Get check index
   checks check(_self, _self.value);
-
-  // Assert that verifier hasn't done this previously
   auto check_by_claim = check.get_index<eosio::name{"byclaim"}>();
-  auto itr_check_claim = check_by_claim.find(claim_id);
 
-  if(itr_check_claim != check_by_claim.end()) {
-    for (; itr_check_claim != check_by_claim.end(); itr_check_claim++) {
-      auto check_claim = *itr_check_claim;
-      eosio_assert(check_claim.validator != verifier, "The verifier cannot check the same claim more than once");
+  // Checks of a claim are next to each other on the index, stop at the first one of another claim.
+  // Assert that verifier hasn't done this previously and count the votes
+  std::uint64_t check_counter = 0;
+  std::uint64_t votes = 1;
+  for (auto itr_check = check_by_claim.lower_bound(claim_id);
+       itr_check != check_by_claim.end() && itr_check->claim_id == claim_id;
+       itr_check++) {
+    BES_COUNT(rows_read);
+    eosio_assert(itr_check->validator != verifier, "The verifier cannot check the same claim more than once");
+    votes++;
+    if (itr_check->is_verified == 1) {
+      check_counter++;
     }
   }
 
@@ -545,36 +782,48 @@ void bespiral::verifyclaim(std::uint64_t claim_id, eosio::name verifier, std::ui
                          c.validator = verifier;
                          c.is_verified = vote;
                        });
+  BES_COUNT(rows_written);
 
   if (objact.verifier_reward.amount > 0) {
-    // Send verification reward
-    std::string memo_verification = "Thanks for verifying an action for your community";
-    eosio::action verification_reward = eosio::action(eosio::permission_level{currency_account, eosio::name{"active"}}, // Permission
-                                                      currency_account,                                                 // Account
-                                                      eosio::name{"issue"},                                             // Action
-                                                      // to, quantity, memo
-                                                      std::make_tuple(verifier, objact.verifier_reward, memo_verification));
-    verification_reward.send();
+    batch.add_verifier_reward(objact.verifier_reward);
   }
 
-  // Do nothing if the vote was negative
-  if (vote == 0) return;
+  // A negative vote only matters when the validators left can no longer verify the claim
+  if (vote == 0) {
+    validators validator(_self, objact.id);
+    std::uint64_t validator_count = 0;
+    for (auto itr_validators = validator.begin(); itr_validators != validator.end(); itr_validators++) {
+      BES_COUNT(rows_read);
+      validator_count++;
+    }
 
-  // When all required checks have been met
-  auto itr_check = check_by_claim.find(claim_id);
-  std::uint64_t check_counter = 0;
-  for (;itr_check != check_by_claim.end();) {
-    if ((*itr_check).is_verified == 1) {
-      check_counter++;
+    std::uint64_t votes_left = validator_count > votes ? validator_count - votes : 0;
+    if (check_counter + votes_left < objact.verifications) {
+      // Rejected, it stops counting as open
+      claim_table.modify(itr_clm, _self, [&](auto &c) { c.is_rejected.emplace(1); });
+      BES_COUNT(rows_written);
+      release_open_claim(claim.claimer, claim.action_id);
+      update_aggregate(community_symbol, [&](auto &a) { if (a.open_claims > 0) a.open_claims--; });
     }
+    return;
+  }
 
-    itr_check++;
+  if (vote == 1) {
+    check_counter++;
   }
 
   // Will only run when a claim has been accepted
   if (check_counter >= objact.verifications) {
     // Set claim as completed
     claim_table.modify(itr_clm, _self, [&](auto &c) { c.is_verified = 1; });
+    BES_COUNT(rows_written);
+    release_open_claim(claim.claimer, claim.action_id);
+
+    update_aggregate(community_symbol, [&](auto &a) {
+                                         if (a.open_claims > 0) a.open_claims--;
+                                         a.verified_claims++;
+                                         a.reward_volume += objact.reward;
+                                       });
 
     if (objact.reward.amount > 0) {
       // Send reward
@@ -585,6 +834,7 @@ void bespiral::verifyclaim(std::uint64_t claim_id, eosio::name verifier, std::ui
                                                   // to, quantity, memo
                                                   std::make_tuple(claim.claimer, objact.reward, memo_action));
       reward_action.send();
+      BES_COUNT(inline_sends);
     }
 
     // Check if action can be completed
@@ -593,11 +843,27 @@ void bespiral::verifyclaim(std::uint64_t claim_id, eosio::name verifier, std::ui
                                          a.usages_left = objact.usages_left -1;
                                          a.is_completed = 1;
                                        });
+      sync_active_action(*itr_objact, community_symbol);
     } else {
       action.modify(itr_objact, _self, [&](auto &a) {
                                          a.usages_left = objact.usages_left -1;
                                        });
     }
+    BES_COUNT(rows_written);
+  }
+}
+
+// Verifier rewards of a batch are paid with a single issue per symbol
+void bespiral::send_verifier_rewards(eosio::name verifier, const vote_batch &batch) {
+  for (const auto &reward : batch.verifier_rewards) {
+    std::string memo_verification = "Thanks for verifying an action for your community";
+    eosio::action verification_reward = eosio::action(eosio::permission_level{currency_account, eosio::name{"active"}}, // Permission
+                                                      currency_account,                                                 // Account
+                                                      eosio::name{"issue"},                                             // Action
+                                                      // to, quantity, memo
+                                                      std::make_tuple(verifier, reward, memo_verification));
+    verification_reward.send();
+    BES_COUNT(inline_sends);
   }
 }
 
@@ -640,12 +906,16 @@ void bespiral::createsale(eosio::name from, std::string title, std::string descr
     s.creator = from;
     s.community = netlink.community;
     s.title = title;
-    s.description = description;
-    s.image = image;
     s.track_stock = track_stock;
     s.quantity = quantity;
     s.units = units;
+    set_text(s.description, s.description_handle, description);
+    set_shared_text(s.image, s.image_handle, image);
   });
+
+  update_aggregate(netlink.community, [&](auto &a) { a.active_sales++; });
+
+  match_buy_orders(sale_id);
 }
 
 void bespiral::updatesale(std::uint64_t sale_id, std::string title,
@@ -684,12 +954,14 @@ void bespiral::updatesale(std::uint64_t sale_id, std::string title,
   // Update sale
   sale.modify(found_sale, _self, [&](auto &s) {
     s.title = title;
-    s.description = description;
-    s.image = image;
     s.quantity = quantity;
     s.units = units;
     s.track_stock = track_stock;
+    set_text(s.description, s.description_handle, description);
+    set_shared_text(s.image, s.image_handle, image);
   });
+
+  match_buy_orders(sale_id);
 }
 
 void bespiral::deletesale(std::uint64_t sale_id) {
@@ -702,7 +974,13 @@ void bespiral::deletesale(std::uint64_t sale_id) {
   // Validate user
   require_auth(found_sale.creator);
 
+  update_aggregate(found_sale.community, [&](auto &a) {
+                                           if (a.active_sales > 0) a.active_sales--;
+                                         });
+
   // Remove sale
+  release_text(found_sale.description_handle);
+  release_text(found_sale.image_handle);
   sale.erase(itr_sale);
 }
 
@@ -778,10 +1056,169 @@ void bespiral::transfersale(std::uint64_t sale_id, eosio::name from, eosio::name
   }
 }
 
+void bespiral::newbuyorder(eosio::name buyer, eosio::name seller, eosio::asset price, std::uint64_t units) {
+  // Validate user
+  require_auth(buyer);
+
+  // Validate accounts are different
+  eosio_assert(buyer != seller, "Can't order from yourself");
+
+  // Validate price and units
+  eosio_assert(price.is_valid(), "Price is invalid");
+  eosio_assert(price.amount > 0, "Invalid amount of price, must use a positive value");
+  eosio_assert(units > 0, "Invalid number of units, must use a positive value");
+
+  // Validate both users belong to community
+  networks network(_self, _self.value);
+  eosio_assert(network.find(gen_uuid(price.symbol.raw(), buyer.value)) != network.end(),
+               "This account doesn't belong to the community");
+  eosio_assert(network.find(gen_uuid(price.symbol.raw(), seller.value)) != network.end(),
+               "The seller doesn't belong to the community");
+
+  buy_orders orders(_self, price.symbol.code().raw());
+  orders.emplace(_self, [&](auto &o) {
+    o.id = orders.available_primary_key();
+    o.buyer = buyer;
+    o.seller = seller;
+    o.price = price;
+    o.units = units;
+  });
+}
+
+void bespiral::cancelorder(eosio::symbol community_symbol, std::uint64_t order_id) {
+  buy_orders orders(_self, community_symbol.code().raw());
+  auto itr_order = orders.find(order_id);
+  eosio_assert(itr_order != orders.end(), "Can't find any buy order with given order_id");
+
+  // Validate user
+  require_auth(itr_order->buyer);
+
+  orders.erase(itr_order);
+}
+
+void bespiral::acceptfill(std::uint64_t fill_id) {
+  order_fills fills(_self, _self.value);
+  auto itr_fill = fills.find(fill_id);
+  eosio_assert(itr_fill != fills.end(), "Can't find any order fill with given fill_id");
+
+  // Validate user
+  require_auth(itr_fill->buyer);
+
+  // Validate the seller still offers it
+  sales sale(_self, _self.value);
+  eosio_assert(sale.find(itr_fill->sale_id) != sale.end(), "The sale of this fill was deleted, reject it instead");
+
+  char buffer[uint64_digits];
+  std::string memo = "Sale ";
+  memo += format_uint64(buffer, itr_fill->sale_id);
+  memo += ", buy order ";
+  memo += format_uint64(buffer, itr_fill->order_id);
+
+  eosio::action(eosio::permission_level{currency_account, eosio::name{"active"}}, // Permission
+                currency_account,                                                 // Account
+                eosio::name{"transfer"},                                          // Action
+                // from, to, quantity, memo
+                std::make_tuple(itr_fill->buyer, itr_fill->seller, itr_fill->total, memo)).send();
+  BES_COUNT(inline_sends);
+
+  fills.erase(itr_fill);
+}
+
+void bespiral::rejectfill(std::uint64_t fill_id) {
+  order_fills fills(_self, _self.value);
+  auto itr_fill = fills.find(fill_id);
+  eosio_assert(itr_fill != fills.end(), "Can't find any order fill with given fill_id");
+
+  // Validate user
+  if (!has_auth(itr_fill->seller))
+    require_auth(itr_fill->buyer);
+
+  // Give the units back, unless the sale is gone or stopped tracking them
+  sales sale(_self, _self.value);
+  auto itr_sale = sale.find(itr_fill->sale_id);
+  if (itr_sale != sale.end() && itr_sale->track_stock == 1) {
+    sale.modify(itr_sale, _self, [&](auto &s) { s.units += itr_fill->units; });
+  }
+
+  fills.erase(itr_fill);
+}
+
+/*
+  Holds units of a stock tracked sale for the buy orders on its seller offering at least its price,
+  best price first, stopping after `max_order_matches` orders. Nothing is paid here: each match
+  takes the units off the sale into an order fill, and the buyer pays the sale price when it signs
+  `acceptfill`, or either side gives them back with `rejectfill`. Sales without tracked stock never
+  match, they have no units to hold. Orders whose buyer can't cover the fill are skipped and keep
+  waiting for a later sale.
+ */
+void bespiral::match_buy_orders(std::uint64_t sale_id) {
+  sales sale(_self, _self.value);
+  auto itr_sale = sale.find(sale_id);
+  if (itr_sale->track_stock != 1 || itr_sale->units == 0 || itr_sale->quantity.amount == 0)
+    return;
+
+  // Orders are scoped by community, the seller's orders elsewhere are never walked
+  buy_orders orders(_self, itr_sale->quantity.symbol.code().raw());
+  auto orders_by_price = orders.get_index<eosio::name{"bysellprice"}>();
+  auto itr_order = orders_by_price.lower_bound(uint128_t(itr_sale->creator.value) << 64);
+
+  order_fills fills(_self, _self.value);
+
+  for (std::size_t matched = 0;
+       matched < max_order_matches && itr_order != orders_by_price.end()
+         && itr_order->seller == itr_sale->creator;
+       matched++) {
+    if (itr_order->price < itr_sale->quantity) break;
+
+    std::uint64_t units = std::min(itr_order->units, itr_sale->units);
+    auto total = itr_sale->quantity * units;
+
+    if (!can_pay(itr_order->buyer, total)) {
+      itr_order++;
+      continue;
+    }
+
+    fills.emplace(_self, [&](auto &f) {
+      f.id = fills.available_primary_key();
+      f.order_id = itr_order->id;
+      f.sale_id = sale_id;
+      f.buyer = itr_order->buyer;
+      f.seller = itr_sale->creator;
+      f.total = total;
+      f.units = units;
+    });
+
+    if (units == itr_order->units) {
+      itr_order = orders_by_price.erase(itr_order);
+    } else {
+      orders_by_price.modify(itr_order, _self, [&](auto &o) { o.units -= units; });
+    }
+
+    sale.modify(itr_sale, _self, [&](auto &s) { s.units -= units; });
+    if (itr_sale->units == 0) break;
+  }
+}
+
+// Whether the token contract will let `buyer` send `quantity`
+bool bespiral::can_pay(eosio::name buyer, const eosio::asset &quantity) {
+  bespiral_tokens tokens(currency_account, quantity.symbol.code().raw());
+  auto itr_stats = tokens.find(quantity.symbol.code().raw());
+  if (itr_stats == tokens.end()) return false;
+
+  bespiral_balances balances(currency_account, buyer.value);
+  auto itr_balance = balances.find(quantity.symbol.code().raw());
+  std::int64_t balance = itr_balance == balances.end() ? 0 : itr_balance->balance.amount;
+
+  if (itr_stats->type == "mcc")
+    return balance - quantity.amount >= itr_stats->min_balance.amount;
+
+  return itr_balance != balances.end() && balance >= quantity.amount;
+}
+
 // set chain indices
 void bespiral::setindices(std::uint64_t sale_id, std::uint64_t objective_id, std::uint64_t action_id, std::uint64_t claim_id) {
   require_auth(_self);
-	indexes default_indexes;
+	indexes default_indexes{};
 	auto current_indexes = curr_indexes.get_or_create(_self, default_indexes);
 
 	current_indexes.last_used_sale_id = sale_id;
@@ -799,7 +1236,920 @@ void bespiral::deleteact(std::uint64_t id) {
   actions action(_self, _self.value);
   auto x = action.find(id);
   eosio_assert(x != action.end(), "Cant find action with given id");
+
+  // `reclaim` still needs the community of the claims left behind, keep it on their summary
+  claims claim(_self, _self.value);
+  auto claims_by_action = claim.get_index<eosio::name{"byaction"}>();
+  if (claims_by_action.find(id) != claims_by_action.end()) {
+    update_claim_summary(*x, [](auto &) {});
+  }
+
+  release_text(x->description_handle);
   action.erase(x);
+
+  active_actions active(_self, _self.value);
+  auto itr_active = active.find(id);
+  if (itr_active != active.end()) active.erase(itr_active);
+}
+
+/*
+  Erases the actions of an objective one after the other, then the objective itself. Every erased
+  row costs one unit of budget, and what is erased is gone from the indexes, so the next call
+  picks up from the first row left.
+ */
+bool bespiral::teardown_objective(std::uint64_t objective_id, std::uint64_t &budget) {
+  objectives objective(_self, _self.value);
+  auto itr_obj = objective.find(objective_id);
+  if (itr_obj == objective.end()) return true;
+
+  actions action(_self, _self.value);
+  auto actions_by_objective = action.get_index<eosio::name{"byobj"}>();
+  for (auto itr_act = actions_by_objective.lower_bound(objective_id);
+       itr_act != actions_by_objective.end() && itr_act->objective_id == objective_id;
+       itr_act = actions_by_objective.lower_bound(objective_id)) {
+    if (!teardown_action(itr_act->id, budget)) return false;
+  }
+
+  if (budget == 0) return false;
+  budget--;
+
+  eosio::symbol community_symbol = itr_obj->community;
+  release_text(itr_obj->description_handle);
+  objective.erase(itr_obj);
+  update_aggregate(community_symbol, [&](auto &a) { if (a.objectives > 0) a.objectives--; });
+  return true;
+}
+
+/*
+  Erases the checks and claims of an action, its validators, its summary and the action row.
+  The aggregates stop counting the erased claims, like a rebuild would.
+ */
+bool bespiral::teardown_action(std::uint64_t action_id, std::uint64_t &budget) {
+  if (budget == 0) return false;
+
+  actions action(_self, _self.value);
+  auto itr_act = action.find(action_id);
+  if (itr_act == action.end()) return true;
+
+  objectives objective(_self, _self.value);
+  auto itr_obj = objective.find(itr_act->objective_id);
+  eosio::symbol community_symbol = itr_obj != objective.end() ? itr_obj->community : itr_act->reward.symbol;
+
+  // Nothing can be claimed or voted on while the action is torn down
+  if (!itr_act->is_completed) {
+    action.modify(itr_act, _self, [&](auto &a) { a.is_completed = 1; });
+  }
+  sync_active_action(*itr_act, community_symbol);
+
+  // Counters taken out of the aggregates, applied once per call
+  std::uint64_t open_claims = 0;
+  std::uint64_t verified_claims = 0;
+  std::int64_t reward_volume = 0;
+  auto update_counters = [&]() {
+                           if (open_claims == 0 && verified_claims == 0 && reward_volume == 0) return;
+                           update_aggregate(community_symbol, [&](auto &a) {
+                                                                a.open_claims -= std::min(a.open_claims, open_claims);
+                                                                a.verified_claims -= std::min(a.verified_claims, verified_claims);
+                                                                a.reward_volume.amount -= std::min(a.reward_volume.amount, reward_volume);
+                                                              });
+                         };
+
+  claims claim(_self, _self.value);
+  checks check(_self, _self.value);
+  auto claims_by_action = claim.get_index<eosio::name{"byaction"}>();
+  auto checks_by_claim = check.get_index<eosio::name{"byclaim"}>();
+
+  // Checks go first, a claim is only erased once none of them is left
+  auto itr_claim = claims_by_action.lower_bound(action_id);
+  while (itr_claim != claims_by_action.end() && itr_claim->action_id == action_id) {
+    auto itr_check = checks_by_claim.lower_bound(itr_claim->id);
+    while (itr_check != checks_by_claim.end() && itr_check->claim_id == itr_claim->id && budget > 0) {
+      budget--;
+      itr_check = checks_by_claim.erase(itr_check);
+    }
+
+    if (budget == 0) {
+      update_counters();
+      return false;
+    }
+    budget--;
+
+    if (itr_claim->is_verified == 1) {
+      verified_claims++;
+      reward_volume += itr_act->reward.amount;
+    } else if (itr_claim->is_open()) {
+      open_claims++;
+      release_open_claim(itr_claim->claimer, action_id);
+    }
+    itr_claim = claims_by_action.erase(itr_claim);
+  }
+
+  validators validator(_self, action_id);
+  for (auto itr_validator = validator.begin(); itr_validator != validator.end();) {
+    if (budget == 0) {
+      update_counters();
+      return false;
+    }
+    budget--;
+    itr_validator = validator.erase(itr_validator);
+  }
+
+  // Claims already erased by `reclaim` are only counted on the summary
+  claim_summaries summary(_self, _self.value);
+  auto itr_summary = summary.find(action_id);
+  if (itr_summary != summary.end() && budget > 0) {
+    budget--;
+    verified_claims += itr_summary->verified_claims;
+    reward_volume += itr_summary->reward_volume.amount;
+    summary.erase(itr_summary);
+  }
+
+  update_counters();
+  if (budget == 0) return false;
+  budget--;
+
+  release_text(itr_act->description_handle);
+  action.erase(itr_act);
+  return true;
+}
+
+/**
+   Close the expired actions of a community.
+   @version 1.0
+
+   Crank anyone can call: marks as completed at most `max_rows` actions whose deadline has passed
+   and drops them from the active actions index, oldest deadline first. Exhausted actions are
+   closed as soon as their last usage is taken, so they never wait for the crank.
+*/
+void bespiral::closeactions(eosio::symbol community_symbol, std::uint64_t max_rows) {
+  eosio_assert(max_rows > 0, "max_rows must be greater than 0");
+
+  close_expired_actions(community_symbol, max_rows);
+}
+
+jobs::slice bespiral::close_expired_actions(eosio::symbol community_symbol, std::uint64_t max_rows) {
+  jobs::slice result{0, 0, false};
+
+  actions action(_self, _self.value);
+  active_actions active(_self, _self.value);
+  auto active_by_deadline = active.get_index<eosio::name{"bycmmdl"}>();
+
+  // Expired actions are the first ones of the community range
+  auto itr = active_by_deadline.lower_bound(bespiral::active_action::key(community_symbol, 1));
+  for (; itr != active_by_deadline.end() && result.rows < max_rows; result.rows++) {
+    if (itr->community != community_symbol || itr->deadline == 0 || itr->deadline > now()) break;
+
+    auto itr_act = action.find(itr->action_id);
+    if (itr_act != action.end() && !itr_act->is_completed) {
+      action.modify(itr_act, _self, [&](auto &a) { a.is_completed = 1; });
+      BES_COUNT(rows_written);
+    }
+
+    itr = active_by_deadline.erase(itr);
+    BES_COUNT(rows_written);
+  }
+
+  result.done = itr == active_by_deadline.end() || itr->community != community_symbol ||
+                itr->deadline == 0 || itr->deadline > now();
+  return result;
+}
+
+/*
+  Keep the active actions index in line with an action that was just written. Expired actions
+  stay on it until `closeactions` completes them, only completed actions leave it here.
+ */
+void bespiral::sync_active_action(const bespiral::action &act, eosio::symbol community_symbol) {
+  active_actions active(_self, _self.value);
+  auto itr = active.find(act.id);
+
+  if (act.is_completed) {
+    if (itr != active.end()) active.erase(itr);
+    return;
+  }
+
+  if (itr == active.end()) {
+    active.emplace(_self, [&](auto &a) {
+                            a.action_id = act.id;
+                            a.community = community_symbol;
+                            a.deadline = act.deadline;
+                          });
+  } else if (itr->deadline != act.deadline) {
+    active.modify(itr, _self, [&](auto &a) { a.deadline = act.deadline; });
+  }
+}
+
+/*
+  Actions written before the active actions index existed have no row on it. Exhausted and
+  expired actions that were never closed get closed here instead.
+ */
+jobs::slice bespiral::index_actions(std::uint64_t from_id, std::uint64_t max_rows) {
+  jobs::slice result{from_id, 0, false};
+
+  actions action(_self, _self.value);
+  objectives objective(_self, _self.value);
+
+  auto itr = action.lower_bound(from_id);
+  for (; itr != action.end() && result.rows < max_rows; itr++, result.rows++) {
+    bool exhausted = itr->usages > 0 && itr->usages_left == 0;
+    bool expired = itr->deadline > 0 && itr->deadline <= now();
+    if (!itr->is_completed && (exhausted || expired)) {
+      action.modify(itr, _self, [&](auto &a) { a.is_completed = 1; });
+    }
+
+    auto itr_obj = objective.find(itr->objective_id);
+    sync_active_action(*itr, itr_obj != objective.end() ? itr_obj->community : itr->reward.symbol);
+
+    result.cursor = itr->id + 1;
+  }
+
+  result.done = itr == action.end();
+  return result;
+}
+
+/**
+   Recompute the aggregates of a community from its tables.
+   @version 1.0
+
+   Walks members, objectives, claims, sales and the summaries left by `reclaim` in that order, visiting at most `max_rows` rows
+   per call and saving its position on the `aggcursor` table. Call it again until the cursor row
+   is gone; the counters are only replaced once every phase is done. Rows added or changed behind
+   the cursor while a rebuild is running are not counted, so run it while the community is quiet.
+*/
+void bespiral::rebuildagg(eosio::symbol community_symbol, std::uint64_t max_rows) {
+  require_auth(_self);
+
+  eosio_assert(max_rows > 0, "max_rows must be greater than 0");
+
+  std::uint64_t budget = max_rows;
+  rebuild_aggregate(community_symbol, budget);
+}
+
+bool bespiral::rebuild_aggregate(eosio::symbol community_symbol, std::uint64_t &budget) {
+  communities community(_self, _self.value);
+  const auto &cmm = community.get(community_symbol.raw(), "can't find any community with given symbol");
+
+  aggregate_cursors cursor_table(_self, _self.value);
+  auto itr_cursor = cursor_table.find(cmm.symbol.raw());
+  if (itr_cursor == cursor_table.end()) {
+    itr_cursor = cursor_table.emplace(_self, [&](auto &c) {
+                                               c.community = cmm.symbol;
+                                               c.phase = 0;
+                                               c.last_id = 0;
+                                               c.counted.community = cmm.symbol;
+                                               c.counted.members = 0;
+                                               c.counted.objectives = 0;
+                                               c.counted.open_claims = 0;
+                                               c.counted.verified_claims = 0;
+                                               c.counted.active_sales = 0;
+                                               c.counted.reward_volume = eosio::asset(0, cmm.symbol);
+                                             });
+  }
+
+  aggregate_cursor cursor = *itr_cursor;
+
+  networks network(_self, _self.value);
+  auto members = network.get_index<eosio::name{"usersbycmm"}>();
+  if (cursor.phase == 0 && rebuild_rows(network, members, cursor, budget, [&](auto &) { cursor.counted.members++; })) {
+    cursor.phase = 1;
+    cursor.last_id = 0;
+  }
+
+  objectives objective(_self, _self.value);
+  auto cmm_objectives = objective.get_index<eosio::name{"bycmm"}>();
+  if (cursor.phase == 1 && rebuild_rows(objective, cmm_objectives, cursor, budget, [&](auto &) { cursor.counted.objectives++; })) {
+    cursor.phase = 2;
+    cursor.last_id = 0;
+  }
+
+  if (cursor.phase == 2 && rebuild_claims(cursor, budget)) {
+    cursor.phase = 3;
+    cursor.last_id = 0;
+  }
+
+  sales sale(_self, _self.value);
+  auto cmm_sales = sale.get_index<eosio::name{"bycmm"}>();
+  if (cursor.phase == 3 && rebuild_rows(sale, cmm_sales, cursor, budget, [&](auto &) { cursor.counted.active_sales++; })) {
+    cursor.phase = 4;
+    cursor.last_id = 0;
+  }
+
+  // Verified claims already erased by `reclaim` only remain on their summaries
+  claim_summaries summary(_self, _self.value);
+  auto cmm_summaries = summary.get_index<eosio::name{"bycmm"}>();
+  auto add_summary = [&](const auto &s) {
+                       cursor.counted.verified_claims += s.verified_claims;
+                       cursor.counted.reward_volume += s.reward_volume;
+                     };
+  if (cursor.phase == 4 && rebuild_rows(summary, cmm_summaries, cursor, budget, add_summary)) {
+    // All phases done, publish the new counters
+    update_aggregate(cmm.symbol, [&](auto &a) { a = cursor.counted; });
+    cursor_table.erase(itr_cursor);
+    return true;
+  }
+
+  cursor_table.modify(itr_cursor, _self, [&](auto &c) { c = cursor; });
+  return false;
+}
+
+/**
+   Queue a maintenance job.
+   @version 1.0
+
+   Jobs wrap the resumable maintenance actions so a keeper can drive all of them the same way
+   with `runjob`. `rebuildagg` and `reclaim` jobs share their cursor with the actions.
+*/
+void bespiral::addjob(eosio::name type, std::uint64_t argument) {
+  require_auth(_self);
+
+  eosio_assert(type == eosio::name{"rebuildagg"} || type == eosio::name{"reclaim"} ||
+               type == eosio::name{"reindexclaim"} || type == eosio::name{"indexacts"} ||
+               type == eosio::name{"closeacts"} || type == eosio::name{"netpaths"} ||
+               type == eosio::name{"delaction"} || type == eosio::name{"delobjective"},
+               "Job type must be some of: 'rebuildagg', 'reclaim', 'reindexclaim', 'indexacts', "
+               "'closeacts', 'netpaths', 'delaction' or 'delobjective'");
+
+  if (type == eosio::name{"delaction"}) {
+    actions action(_self, _self.value);
+    action.get(argument, "Can't find action with given id");
+  }
+
+  if (type == eosio::name{"delobjective"}) {
+    objectives objective(_self, _self.value);
+    objective.get(argument, "Can't find objective with given id");
+  }
+
+  if (type == eosio::name{"rebuildagg"} || type == eosio::name{"closeacts"}) {
+    communities community(_self, _self.value);
+    community.get(argument, "can't find any community with given symbol");
+  }
+
+  // Claims opened after the upgrade are already indexed and counted, stop at the last one from before it
+  if (type == eosio::name{"reindexclaim"}) {
+    eosio_assert(argument == 0, "reindexclaim finds the last claim from before the upgrade, its argument must be 0");
+
+    indexes default_indexes{};
+    auto current_indexes = curr_indexes.get_or_default(default_indexes);
+    std::uint64_t first_counted = current_indexes.first_counted_claim_id.value_or(0);
+    argument = first_counted == 0 ? current_indexes.last_used_claim_id : first_counted - 1;
+  }
+
+  maintenance_jobs job(_self, _self.value);
+  jobs::add(job, _self, type, argument);
+}
+
+void bespiral::runjob(std::uint64_t id, std::uint64_t max_rows) {
+  require_auth(_self);
+
+  maintenance_jobs job(_self, _self.value);
+  jobs::run(job, _self, id, max_rows, [&](const auto &j, std::uint64_t max_rows) -> jobs::slice {
+      if (j.type == eosio::name{"reindexclaim"}) {
+        return reindex_claims(j.cursor, j.argument, max_rows);
+      }
+
+      if (j.type == eosio::name{"indexacts"}) {
+        return index_actions(j.cursor, max_rows);
+      }
+
+      if (j.type == eosio::name{"closeacts"}) {
+        return close_expired_actions(eosio::symbol(j.argument), max_rows);
+      }
+
+      if (j.type == eosio::name{"netpaths"}) {
+        return index_network(j.cursor, max_rows);
+      }
+
+      // These keep their own cursor, or resume from the first row left on an index
+      std::uint64_t budget = max_rows;
+      bool done = false;
+      if (j.type == eosio::name{"rebuildagg"}) {
+        done = rebuild_aggregate(eosio::symbol(j.argument), budget);
+      } else if (j.type == eosio::name{"delaction"}) {
+        done = teardown_action(j.argument, budget);
+      } else if (j.type == eosio::name{"delobjective"}) {
+        done = teardown_objective(j.argument, budget);
+      } else {
+        done = reclaim_pass(budget);
+      }
+      return jobs::slice{0, max_rows - budget, done};
+    });
+}
+
+/**
+   Export the rows of a table for a chain migration.
+   @version 1.0
+
+   Rows are sent packed on an inline `rowspage` action, where history nodes keep them. A page holds
+   at most `max_rows` rows and stops earlier at `bulk::max_page_bytes`, to fit the inline action
+   size limit. Pass its `next_id` as `from_id` to get the next page, until it is 0. Validators are scoped by action,
+   every other table uses the contract account as scope.
+*/
+void bespiral::exportrows(eosio::name table, std::uint64_t scope, std::uint64_t from_id, std::uint64_t max_rows) {
+  require_auth(_self);
+
+  eosio_assert(max_rows > 0, "max_rows must be greater than 0");
+
+  bulk::packed_rows rows;
+  std::uint64_t next_id = 0;
+  with_table(table, scope, [&](auto &t) { next_id = bulk::export_page(t, from_id, max_rows, rows); });
+
+  SEND_INLINE_ACTION(*this,
+                     rowspage,
+                     {_self, eosio::name{"active"}},
+                     {table, scope, next_id, rows});
+}
+
+void bespiral::rowspage(eosio::name table, std::uint64_t scope, std::uint64_t next_id, bulk::packed_rows rows) {
+  require_auth(_self);
+}
+
+/**
+   Import rows exported from another chain.
+   @version 1.0
+
+   Rows are stored as they are, without any validation. Once every table is imported, restore the
+   id counters with `setindices`, count the open claims with a `reindexclaim` job, index the open
+   actions with an `indexacts` job and run `rebuildagg` for each community.
+*/
+void bespiral::importrows(eosio::name table, std::uint64_t scope, bulk::packed_rows rows) {
+  require_auth(_self);
+
+  with_table(table, scope, [&](auto &t) { bulk::import_page(t, _self, rows); });
+}
+
+template <typename Lambda>
+void bespiral::with_table(eosio::name table, std::uint64_t scope, Lambda &&f) {
+  if (table == eosio::name{"validator"}) {
+    validators t(_self, scope);
+    f(t);
+    return;
+  }
+
+  eosio_assert(scope == _self.value, "Only validators are scoped, use the contract account as scope");
+
+  if (table == eosio::name{"community"}) {
+    communities t(_self, scope);
+    f(t);
+  } else if (table == eosio::name{"network"}) {
+    networks t(_self, scope);
+    f(t);
+  } else if (table == eosio::name{"objective"}) {
+    objectives t(_self, scope);
+    f(t);
+  } else if (table == eosio::name{"action"}) {
+    actions t(_self, scope);
+    f(t);
+  } else if (table == eosio::name{"claim"}) {
+    claims t(_self, scope);
+    f(t);
+  } else if (table == eosio::name{"check"}) {
+    checks t(_self, scope);
+    f(t);
+  } else if (table == eosio::name{"sale"}) {
+    sales t(_self, scope);
+    f(t);
+  } else if (table == eosio::name{"blobs"}) {
+    blobs t(_self, scope);
+    f(t);
+  } else if (table == eosio::name{"claimsummary"}) {
+    claim_summaries t(_self, scope);
+    f(t);
+  } else if (table == eosio::name{"referrals"}) {
+    referral_configs t(_self, scope);
+    f(t);
+  } else if (table == eosio::name{"buyorders"}) {
+    buy_orders t(_self, scope);
+    f(t);
+  } else if (table == eosio::name{"orderfills"}) {
+    order_fills t(_self, scope);
+    f(t);
+  } else {
+    eosio_assert(false, "Table must be some of: 'community', 'network', 'objective', 'action', 'validator', "
+                        "'claim', 'check', 'sale', 'blobs', 'claimsummary', 'referrals', 'buyorders' or 'orderfills'");
+  }
+}
+
+/*
+  Claims written before the claimer indexes existed have no entries on them, and nothing counts
+  them as open. Erasing and emplacing a row again writes all of its index entries.
+ */
+jobs::slice bespiral::reindex_claims(std::uint64_t from_id, std::uint64_t last_id, std::uint64_t max_rows) {
+  jobs::slice result{from_id, 0, false};
+
+  claims claim(_self, _self.value);
+  auto itr = claim.lower_bound(from_id);
+  for (; itr != claim.end() && itr->id <= last_id && result.rows < max_rows; result.rows++) {
+    auto row = *itr;
+    claim.erase(itr);
+    claim.emplace(_self, [&](auto &c) { c = row; });
+
+    if (row.is_open()) add_open_claim(row.claimer, row.action_id);
+
+    result.cursor = row.id + 1;
+    itr = claim.lower_bound(result.cursor);
+  }
+
+  result.done = itr == claim.end() || itr->id > last_id;
+  return result;
+}
+
+void bespiral::add_open_claim(eosio::name claimer, std::uint64_t action_id) {
+  open_claim_counts open_count(_self, claimer.value);
+  auto itr_open = open_count.find(action_id);
+
+  if (itr_open == open_count.end()) {
+    open_count.emplace(_self, [&](auto &o) {
+                                o.action_id = action_id;
+                                o.open = 1;
+                              });
+  } else {
+    open_count.modify(itr_open, _self, [&](auto &o) { o.open++; });
+  }
+}
+
+// Claims from before the counters existed have no row, there is nothing to release for them
+void bespiral::release_open_claim(eosio::name claimer, std::uint64_t action_id) {
+  open_claim_counts open_count(_self, claimer.value);
+  auto itr_open = open_count.find(action_id);
+  if (itr_open == open_count.end()) return;
+
+  if (itr_open->open <= 1) {
+    open_count.erase(itr_open);
+  } else {
+    open_count.modify(itr_open, _self, [&](auto &o) { o.open--; });
+  }
+}
+
+void bespiral::throttle_claims(eosio::name claimer) {
+  throttle_configs config(_self, _self.value);
+  throttle_config default_config{};
+  auto cfg = config.get_or_default(default_config);
+  if (cfg.window == 0) return;
+
+  std::uint32_t current_time = now();
+  std::uint32_t window_start = current_time - current_time % cfg.window;
+
+  claim_throttles throttle(_self, _self.value);
+  auto itr_throttle = throttle.find(claimer.value);
+
+  std::uint32_t current = 0;
+  std::uint32_t previous = 0;
+  if (itr_throttle != throttle.end()) {
+    if (itr_throttle->window_start == window_start) {
+      current = itr_throttle->current;
+      previous = itr_throttle->previous;
+    } else if (itr_throttle->window_start + cfg.window == window_start) {
+      previous = itr_throttle->current;
+    }
+  }
+
+  // The previous window weighs as much as it still overlaps the last `window` seconds, rounded up
+  std::uint64_t elapsed = current_time - window_start;
+  std::uint64_t estimate = current + (std::uint64_t(previous) * (cfg.window - elapsed) + cfg.window - 1) / cfg.window;
+  eosio_assert(estimate < cfg.max_claims, "Too many claims opened recently, try again later");
+
+  auto update = [&](auto &t) {
+                  t.claimer = claimer;
+                  t.window_start = window_start;
+                  t.current = current + 1;
+                  t.previous = previous;
+                };
+  if (itr_throttle == throttle.end()) {
+    throttle.emplace(_self, update);
+  } else {
+    throttle.modify(itr_throttle, _self, update);
+  }
+}
+
+template <typename Table, typename Index, typename Lambda>
+bool bespiral::rebuild_rows(Table &table, Index &index, aggregate_cursor &cursor,
+                            std::uint64_t &budget, Lambda &&count) {
+  auto itr = index.lower_bound(cursor.community.raw());
+
+  if (cursor.last_id != 0) {
+    auto itr_last = table.find(cursor.last_id);
+    if (itr_last != table.end()) {
+      itr = index.iterator_to(*itr_last);
+      itr++;
+    } else {
+      // Last visited row is gone, skip the ones already counted
+      while (itr != index.end() && itr->community == cursor.community && itr->primary_key() <= cursor.last_id)
+        itr++;
+    }
+  }
+
+  for (; itr != index.end() && itr->community == cursor.community; itr++) {
+    if (budget == 0) return false;
+    budget--;
+
+    count(*itr);
+    cursor.last_id = itr->primary_key();
+  }
+
+  return true;
+}
+
+bool bespiral::rebuild_claims(aggregate_cursor &cursor, std::uint64_t &budget) {
+  claims claim(_self, _self.value);
+  actions action(_self, _self.value);
+  objectives objective(_self, _self.value);
+
+  // Claims have no community index, walk all of them resolving each action only once
+  std::uint64_t last_action_id = 0;
+  bool last_action_matches = false;
+  eosio::asset last_reward;
+
+  for (auto itr = claim.upper_bound(cursor.last_id); itr != claim.end(); itr++) {
+    if (budget == 0) return false;
+    budget--;
+
+    cursor.last_id = itr->id;
+
+    if (itr->action_id != last_action_id) {
+      last_action_id = itr->action_id;
+      last_action_matches = false;
+
+      auto itr_act = action.find(itr->action_id);
+      if (itr_act != action.end()) {
+        auto itr_obj = objective.find(itr_act->objective_id);
+        last_action_matches = itr_obj != objective.end() && itr_obj->community == cursor.community;
+        last_reward = itr_act->reward;
+      }
+    }
+
+    if (!last_action_matches) continue;
+
+    if (itr->is_verified == 1) {
+      cursor.counted.verified_claims++;
+      cursor.counted.reward_volume += last_reward;
+    } else if (itr->is_open()) {
+      cursor.counted.open_claims++;
+    }
+  }
+
+  return true;
+}
+
+template <typename Lambda>
+void bespiral::update_aggregate(eosio::symbol community_symbol, Lambda &&updater) {
+  aggregates aggregate(_self, _self.value);
+  auto itr_agg = aggregate.find(community_symbol.raw());
+
+  if (itr_agg == aggregate.end()) {
+    aggregate.emplace(_self, [&](auto &a) {
+                               a.community = community_symbol;
+                               a.members = 0;
+                               a.objectives = 0;
+                               a.open_claims = 0;
+                               a.verified_claims = 0;
+                               a.active_sales = 0;
+                               a.reward_volume = eosio::asset(0, community_symbol);
+                               updater(a);
+                             });
+  } else {
+    aggregate.modify(itr_agg, _self, updater);
+  }
+}
+
+/**
+   Erase finished claims with their checks, then the validators left behind by deleted actions.
+   @version 1.0
+
+   A claim is finished once it is verified or its action can no longer take votes: completed,
+   past its deadline or deleted. Claims of existing actions are added up on the `claimsummary`
+   row of the action before being erased, so aggregates can still be rebuilt afterwards.
+   Visits at most `max_rows` rows per call and keeps its position on the `reclaimcur` singleton,
+   starting a new pass over both phases once the last one is done.
+*/
+void bespiral::reclaim(std::uint64_t max_rows) {
+  require_auth(_self);
+
+  eosio_assert(max_rows > 0, "max_rows must be greater than 0");
+
+  std::uint64_t budget = max_rows;
+  reclaim_pass(budget);
+}
+
+bool bespiral::reclaim_pass(std::uint64_t &budget) {
+  reclaim_cursors cursor_table(_self, _self.value);
+  reclaim_cursor default_cursor{};
+  reclaim_cursor cursor = cursor_table.get_or_default(default_cursor);
+  bool pass_done = false;
+
+  if (cursor.phase == 0 && reclaim_claims(cursor, budget)) {
+    cursor.phase = 1;
+    cursor.next_id = 0;
+  }
+
+  if (cursor.phase == 1 && reclaim_validators(cursor, budget)) {
+    cursor.phase = 0;
+    cursor.next_id = 0;
+    pass_done = true;
+  }
+
+  cursor_table.set(cursor, _self);
+  return pass_done;
+}
+
+bool bespiral::reclaim_claims(reclaim_cursor &cursor, std::uint64_t &budget) {
+  claims claim(_self, _self.value);
+  checks check(_self, _self.value);
+  actions action(_self, _self.value);
+  auto checks_by_claim = check.get_index<eosio::name{"byclaim"}>();
+
+  // Kept claims and erased rows count against the budget, so every call makes some progress
+  for (auto itr = claim.lower_bound(cursor.next_id); itr != claim.end();) {
+    if (budget == 0) return false;
+
+    cursor.next_id = itr->id;
+
+    auto itr_act = action.find(itr->action_id);
+    bool has_action = itr_act != action.end();
+    bool closed = !has_action || itr_act->is_completed ||
+                  (itr_act->deadline > 0 && itr_act->deadline <= now());
+
+    if (itr->is_open() && !closed) {
+      budget--;
+      cursor.next_id = itr->id + 1;
+      itr++;
+      continue;
+    }
+
+    // Checks go first, a claim is only erased once none of them is left
+    std::uint64_t erased_checks = 0;
+    auto itr_check = checks_by_claim.lower_bound(itr->id);
+    while (itr_check != checks_by_claim.end() && itr_check->claim_id == itr->id && budget > 0) {
+      budget--;
+      itr_check = checks_by_claim.erase(itr_check);
+      erased_checks++;
+    }
+    bool checks_left = itr_check != checks_by_claim.end() && itr_check->claim_id == itr->id;
+    bool erase_claim = !checks_left && budget > 0;
+    if (erase_claim) budget--;
+
+    eosio::symbol community_symbol;
+    if (has_action) {
+      community_symbol = update_claim_summary(*itr_act, [&](auto &s) {
+                                                          s.checks += erased_checks;
+                                                          if (!erase_claim) return;
+                                                          if (itr->is_verified == 1) {
+                                                            s.verified_claims++;
+                                                            s.reward_volume += itr_act->reward;
+                                                          } else {
+                                                            s.rejected_claims++;
+                                                          }
+                                                        });
+    } else {
+      // Deleted by `deleteact`, which left the community on the summary
+      claim_summaries summary(_self, _self.value);
+      auto itr_summary = summary.find(itr->action_id);
+      if (itr_summary != summary.end()) community_symbol = itr_summary->community;
+    }
+
+    // Out of budget, the next call resumes with this claim
+    if (!erase_claim) return false;
+
+    if (itr->is_open()) {
+      release_open_claim(itr->claimer, itr->action_id);
+      if (community_symbol.raw() != 0) update_aggregate(community_symbol, [&](auto &a) { if (a.open_claims > 0) a.open_claims--; });
+    }
+
+    cursor.next_id = itr->id + 1;
+    itr = claim.erase(itr);
+  }
+
+  return true;
+}
+
+bool bespiral::reclaim_validators(reclaim_cursor &cursor, std::uint64_t &budget) {
+  actions action(_self, _self.value);
+
+  // Validators are scoped by action, so only ids up to the last one handed out can have any
+  indexes default_indexes{};
+  auto current_indexes = curr_indexes.get_or_default(default_indexes);
+
+  for (std::uint64_t id = cursor.next_id; id <= current_indexes.last_used_action_id; id++) {
+    if (budget == 0) return false;
+
+    cursor.next_id = id;
+
+    // Live actions keep their validators, visiting them costs one row like an empty scope
+    validators validator(_self, id);
+    auto itr = validator.begin();
+    if (itr == validator.end() || action.find(id) != action.end()) {
+      budget--;
+      cursor.next_id = id + 1;
+      continue;
+    }
+
+    while (itr != validator.end()) {
+      if (budget == 0) return false;
+      budget--;
+      itr = validator.erase(itr);
+    }
+
+    cursor.next_id = id + 1;
+  }
+
+  return true;
+}
+
+template <typename Lambda>
+eosio::symbol bespiral::update_claim_summary(const bespiral::action &act, Lambda &&updater) {
+  claim_summaries summary(_self, _self.value);
+  auto itr_summary = summary.find(act.id);
+
+  if (itr_summary == summary.end()) {
+    objectives objective(_self, _self.value);
+    auto itr_obj = objective.find(act.objective_id);
+
+    auto itr_new = summary.emplace(_self, [&](auto &s) {
+                                        s.action_id = act.id;
+                                        s.community = itr_obj != objective.end() ? itr_obj->community : act.reward.symbol;
+                                        s.verified_claims = 0;
+                                        s.rejected_claims = 0;
+                                        s.checks = 0;
+                                        s.reward_volume = eosio::asset(0, act.reward.symbol);
+                                        updater(s);
+                                      });
+    return itr_new->community;
+  }
+
+  summary.modify(itr_summary, _self, updater);
+  return itr_summary->community;
+}
+
+/*
+  Logos and images are URLs that many rows repeat, so those longer than `blob_min_size` are kept
+  once on the blobs table, keyed by their sha256, and the row only stores the blob id on its handle.
+  A blob costs a row of its own, its hash and an index entry, some 300 bytes, so it only saves RAM
+  on texts that are shared: descriptions, which are mostly unique, stay inline with a 0 handle.
+  Rows written before handles existed have no handle at all and keep their inline text.
+ */
+void bespiral::set_shared_text(std::string &field, eosio::binary_extension<std::uint64_t> &handle, const std::string &value) {
+  std::uint64_t old_blob = handle.value_or(0);
+
+  // Acquire before releasing, so an unchanged text keeps its blob
+  if (value.size() >= blob_min_size) {
+    field = "";
+    handle.emplace(acquire_blob(value));
+  } else {
+    field = value;
+    handle.emplace(0);
+  }
+
+  if (old_blob != 0) release_blob(old_blob);
+}
+
+// Descriptions moved to blobs by earlier versions come back inline on their next update
+void bespiral::set_text(std::string &field, eosio::binary_extension<std::uint64_t> &handle, const std::string &value) {
+  std::uint64_t old_blob = handle.value_or(0);
+
+  field = value;
+  handle.emplace(0);
+
+  if (old_blob != 0) release_blob(old_blob);
+}
+
+void bespiral::release_text(const eosio::binary_extension<std::uint64_t> &handle) {
+  if (handle.value_or(0) != 0) release_blob(handle.value());
+}
+
+std::uint64_t bespiral::acquire_blob(const std::string &data) {
+  capi_checksum256 digest;
+  sha256(data.c_str(), data.size(), &digest);
+  eosio::checksum256 hash(digest.hash);
+
+  blobs blob(_self, _self.value);
+  auto blobs_by_hash = blob.get_index<eosio::name{"byhash"}>();
+  auto itr_blob = blobs_by_hash.find(hash);
+
+  if (itr_blob != blobs_by_hash.end()) {
+    blobs_by_hash.modify(itr_blob, _self, [&](auto &b) { b.refs++; });
+    return itr_blob->id;
+  }
+
+  // Id 0 is reserved for "no blob"
+  std::uint64_t blob_id = std::max<std::uint64_t>(blob.available_primary_key(), 1);
+  blob.emplace(_self, [&](auto &b) {
+                        b.id = blob_id;
+                        b.hash = hash;
+                        b.refs = 1;
+                        b.data = data;
+                      });
+
+  return blob_id;
+}
+
+void bespiral::release_blob(std::uint64_t blob_id) {
+  blobs blob(_self, _self.value);
+  auto itr_blob = blob.find(blob_id);
+  eosio_assert(itr_blob != blob.end(), "Can't find blob with given id");
+
+  if (itr_blob->refs <= 1) {
+    blob.erase(itr_blob);
+  } else {
+    blob.modify(itr_blob, _self, [&](auto &b) { b.refs--; });
+  }
 }
 
 // Get available key
@@ -807,7 +2157,7 @@ uint64_t bespiral::get_available_id(std::string table) {
   eosio_assert(table == "actions" || table == "objectives" || table == "sales" || table == "claims", "Table index not available");
 
   // Init indexes table
-  indexes default_indexes;
+  indexes default_indexes{};
   auto current_indexes = curr_indexes.get_or_create(_self, default_indexes);
 
   uint64_t id = 1;
@@ -827,6 +2177,8 @@ uint64_t bespiral::get_available_id(std::string table) {
    } else if(table == "claims") {
       id = current_indexes.last_used_claim_id + 1;
       current_indexes.last_used_claim_id = id;
+      // claimaction counts every claim from here on
+      if (current_indexes.first_counted_claim_id.value_or(0) == 0) current_indexes.first_counted_claim_id.emplace(id);
       curr_indexes.set(current_indexes, _self);
   }
 
@@ -834,9 +2186,31 @@ uint64_t bespiral::get_available_id(std::string table) {
 }
 
 
-EOSIO_DISPATCH(bespiral,
-               (create)(update)(netlink)(newobjective)
-               (updobjective)(upsertaction)(verifyaction)
-               (claimaction)(verifyclaim)(createsale)
-               (updatesale) (deletesale)(reactsale)
-               (transfersale)(setindices)(deleteact));
+extern "C" {
+  void apply(uint64_t receiver, uint64_t code, uint64_t action) {
+    if (code != receiver) return;
+
+    switch (action) {
+      // Hot actions, decoded straight from the action data
+      case eosio::name("netlink").value:
+        args::execute(receiver, code, &bespiral::netlink);
+        break;
+      case eosio::name("claimaction").value:
+        args::execute(receiver, code, &bespiral::claimaction);
+        break;
+      case eosio::name("verifyclaim").value:
+        args::execute(receiver, code, &bespiral::verifyclaim);
+        break;
+
+      EOSIO_DISPATCH_HELPER(bespiral,
+                            (create)(update)(setreferral)(newobjective)
+                            (updobjective)(upsertaction)(verifyaction)
+                            (setthrottle)(verifyclaims)(createsale)
+                            (updatesale) (deletesale)(reactsale)
+                            (transfersale)(newbuyorder)(cancelorder)(acceptfill)(rejectfill)(setindices)(deleteact)(closeactions)
+                            (rebuildagg)(reclaim)
+                            (addjob)(runjob)(exportrows)
+                            (rowspage)(importrows))
+    }
+  }
+}
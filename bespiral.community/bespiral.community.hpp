@@ -3,6 +3,24 @@
 #include <eosiolib/system.h>
 #include<eosiolib/singleton.hpp>
 #include <eosiolib/crypto.h>
+#include <eosiolib/binary_extension.hpp>
+
+#include <map>
+
+#include "../utils/views.hpp"
+#include "../utils/trace.hpp"
+#include "../utils/jobs.hpp"
+#include "../utils/bulk.hpp"
+#include "../utils/args.hpp"
+
+// Shared texts shorter than this stay inline, a blob handle would not make the row any smaller
+const std::uint32_t blob_min_size = 32;
+
+// Inviters kept on each network row, the direct inviter included
+const std::size_t max_referral_depth = 5;
+
+// Buy orders a single createsale or updatesale can fill
+const std::size_t max_order_matches = 10;
 
 class [[eosio::contract("bespiral.community")]] bespiral : public eosio::contract {
  public:
@@ -18,12 +36,15 @@ class [[eosio::contract("bespiral.community")]] bespiral : public eosio::contrac
     std::string description;
     eosio::asset inviter_reward;
     eosio::asset invited_reward;
+    eosio::binary_extension<std::uint64_t> logo_handle; // Blob holding the logo when `logo` is empty
+    eosio::binary_extension<std::uint64_t> description_handle;
 
     uint64_t primary_key() const { return symbol.raw(); };
 
     EOSLIB_SERIALIZE(community,
                      (symbol)(creator)(logo)(name)(description)
-                     (inviter_reward)(invited_reward));
+                     (inviter_reward)(invited_reward)
+                     (logo_handle)(description_handle));
   };
 
   TABLE network {
@@ -33,12 +54,37 @@ class [[eosio::contract("bespiral.community")]] bespiral : public eosio::contrac
     eosio::name invited_user;
     eosio::name invited_by;
 
+    // Members up to `max_referral_depth` levels below this one. Comes before `ancestors` so it can
+    // be counted on rows written before either existed
+    eosio::binary_extension<std::uint64_t> subtree_size;
+
+    // Inviters of this member, nearest first. Only valid when `is_indexed` is 1
+    eosio::binary_extension<std::vector<eosio::name>> ancestors;
+
+    // 1 once `ancestors` is set and this member is counted on its ancestors' subtree. Legacy rows
+    // read 0 until the `netpaths` job indexes them, even after a modify has written empty
+    // `ancestors` for them
+    eosio::binary_extension<std::uint8_t> is_indexed;
+
     // keys and indexes
     std::uint64_t primary_key() const { return id; }
     std::uint64_t users_by_cmm() const { return community.raw(); }
 
+    bool has_ancestors() const { return is_indexed.value_or(0) == 1; }
+
     EOSLIB_SERIALIZE(network,
-                     (id)(community)(invited_user)(invited_by));
+                     (id)(community)(invited_user)(invited_by)
+                     (subtree_size)(ancestors)(is_indexed));
+  };
+
+  // Rewards for the inviters above the direct one
+  TABLE referral_config {
+    eosio::symbol community;
+    std::vector<std::uint16_t> level_rates; // Basis points of the inviter reward, from the second level up
+
+    std::uint64_t primary_key() const { return community.raw(); }
+
+    EOSLIB_SERIALIZE(referral_config, (community)(level_rates));
   };
 
   TABLE objective {
@@ -46,6 +92,7 @@ class [[eosio::contract("bespiral.community")]] bespiral : public eosio::contrac
     std::string description;
     eosio::symbol community;
     eosio::name creator;
+    eosio::binary_extension<std::uint64_t> description_handle;
 
     // keys and indexes
     std::uint64_t primary_key() const { return id; }
@@ -53,7 +100,8 @@ class [[eosio::contract("bespiral.community")]] bespiral : public eosio::contrac
 
     EOSLIB_SERIALIZE(objective,
                      (id)(description)
-                     (community)(creator));
+                     (community)(creator)
+                     (description_handle));
   };
 
   TABLE action {
@@ -69,6 +117,8 @@ class [[eosio::contract("bespiral.community")]] bespiral : public eosio::contrac
     std::string verification_type; // Can be 'automatic' and 'claimable'
     std::uint8_t is_completed;
     eosio::name creator;
+    eosio::binary_extension<std::uint64_t> description_handle;
+    eosio::binary_extension<std::uint64_t> max_open_claims; // Open claims a user can have at once, 0 for no limit
 
     std::uint64_t primary_key() const { return id; }
     std::uint64_t by_objective() const { return objective_id; }
@@ -77,7 +127,29 @@ class [[eosio::contract("bespiral.community")]] bespiral : public eosio::contrac
                      (id)(objective_id)(description)(reward)
                      (verifier_reward)(deadline)(usages)
                      (usages_left)(verifications)
-                     (verification_type)(is_completed)(creator));
+                     (verification_type)(is_completed)(creator)
+                     (description_handle)(max_open_claims));
+  };
+
+  /*
+    Actions that are not completed, ordered by community and deadline. Actions without a
+    deadline sort after the dated ones, so the actions open right now are the single range from
+    `key(community, now() + 1)` to the end of the community, and the expired ones left for
+    `closeactions` are a prefix of it.
+   */
+  TABLE active_action {
+    std::uint64_t action_id;
+    eosio::symbol community;
+    std::uint64_t deadline; // 0 for actions without one
+
+    std::uint64_t primary_key() const { return action_id; }
+    uint128_t by_cmm_deadline() const { return key(community, deadline); }
+
+    static uint128_t key(eosio::symbol community, std::uint64_t deadline) {
+      return (uint128_t(community.raw()) << 64) | (deadline == 0 ? UINT64_MAX : deadline);
+    }
+
+    EOSLIB_SERIALIZE(active_action, (action_id)(community)(deadline));
   };
 
   TABLE action_validator {
@@ -97,12 +169,18 @@ class [[eosio::contract("bespiral.community")]] bespiral : public eosio::contrac
     std::uint64_t action_id;
     eosio::name claimer;
     std::uint8_t is_verified; // If the number of verifications reached the necessary #
+    eosio::binary_extension<std::uint8_t> is_rejected; // 1 once the validators left can't verify it anymore
+
+    bool was_rejected() const { return is_rejected.value_or(0) == 1; }
+    bool is_open() const { return is_verified == 0 && !was_rejected(); }
 
     std::uint64_t primary_key() const { return id; }
     std::uint64_t by_action() const { return action_id; }
+    std::uint64_t by_claimer() const { return claimer.value; }
+    uint128_t by_action_claimer() const { return (uint128_t(action_id) << 64) | claimer.value; }
 
     EOSLIB_SERIALIZE(claim,
-                     (id)(action_id)(claimer)(is_verified));
+                     (id)(action_id)(claimer)(is_verified)(is_rejected));
   };
 
   TABLE check {
@@ -118,6 +196,34 @@ class [[eosio::contract("bespiral.community")]] bespiral : public eosio::contrac
                      (id)(claim_id)(validator)(is_verified));
   };
 
+  // Unverified claims of a user on one action, scoped by claimer
+  TABLE open_claim_count {
+    std::uint64_t action_id;
+    std::uint64_t open;
+
+    std::uint64_t primary_key() const { return action_id; }
+
+    EOSLIB_SERIALIZE(open_claim_count, (action_id)(open));
+  };
+
+  // Claims of a user on the current and previous throttle windows
+  TABLE claim_throttle {
+    eosio::name claimer;
+    std::uint32_t window_start;
+    std::uint32_t current;
+    std::uint32_t previous;
+
+    std::uint64_t primary_key() const { return claimer.value; }
+
+    EOSLIB_SERIALIZE(claim_throttle,
+                     (claimer)(window_start)(current)(previous));
+  };
+
+  TABLE throttle_config {
+    std::uint32_t window;     // Seconds, 0 disables the throttle
+    std::uint32_t max_claims; // Claims a user can open in any window
+  };
+
   TABLE sale {
     std::uint64_t id;
     eosio::name creator;
@@ -128,6 +234,8 @@ class [[eosio::contract("bespiral.community")]] bespiral : public eosio::contrac
     std::uint8_t track_stock;
     eosio::asset quantity;    // Actual price of product/service
     std::uint64_t units;      // How many are available
+    eosio::binary_extension<std::uint64_t> description_handle;
+    eosio::binary_extension<std::uint64_t> image_handle;
 
     std::uint64_t primary_key() const { return id; }
     std::uint64_t by_cmm() const { return community.raw(); }
@@ -136,7 +244,56 @@ class [[eosio::contract("bespiral.community")]] bespiral : public eosio::contrac
     EOSLIB_SERIALIZE(sale,
                      (id)(creator)(community)
                      (title)(description)(image)
-                     (track_stock)(quantity)(units));
+                     (track_stock)(quantity)(units)
+                     (description_handle)(image_handle));
+  };
+
+  // Standing offer to buy up to `units` from `seller` at no more than `price` each, matched by
+  // the seller's new and updated sales that track stock. Scoped by the community symbol code
+  TABLE buy_order {
+    std::uint64_t id;
+    eosio::name buyer;
+    eosio::name seller;
+    eosio::asset price; // Per unit, in the community token
+    std::uint64_t units;
+
+    std::uint64_t primary_key() const { return id; }
+
+    // Best price first for each seller, older orders first on the same price
+    uint128_t by_seller_price() const {
+      return (uint128_t(seller.value) << 64) | (UINT64_MAX - std::uint64_t(price.amount));
+    }
+
+    EOSLIB_SERIALIZE(buy_order, (id)(buyer)(seller)(price)(units));
+  };
+
+  // Units of a sale held for a buy order, paid only when the buyer accepts them
+  TABLE order_fill {
+    std::uint64_t id;
+    std::uint64_t order_id;
+    std::uint64_t sale_id;
+    eosio::name buyer;
+    eosio::name seller;
+    eosio::asset total; // Sale price times units
+    std::uint64_t units;
+
+    std::uint64_t primary_key() const { return id; }
+
+    EOSLIB_SERIALIZE(order_fill, (id)(order_id)(sale_id)(buyer)(seller)(total)(units));
+  };
+
+  // Texts shared between rows, stored once and counted by reference
+  TABLE blob {
+    std::uint64_t id;
+    eosio::checksum256 hash; // sha256 of data
+    std::uint64_t refs;
+    std::string data;
+
+    std::uint64_t primary_key() const { return id; }
+    eosio::checksum256 by_hash() const { return hash; }
+
+    EOSLIB_SERIALIZE(blob,
+                     (id)(hash)(refs)(data));
   };
 
   TABLE indexes {
@@ -144,6 +301,102 @@ class [[eosio::contract("bespiral.community")]] bespiral : public eosio::contrac
     std::uint64_t last_used_objective_id;
     std::uint64_t last_used_action_id;
     std::uint64_t last_used_claim_id;
+
+    // First claim counted on the open claims counters when it was opened, 0 until there is one.
+    // Claims before it are counted by the `reindexclaim` job
+    eosio::binary_extension<std::uint64_t> first_counted_claim_id;
+  };
+
+  TABLE aggregate {
+    eosio::symbol community;
+    std::uint64_t members;
+    std::uint64_t objectives;
+    std::uint64_t open_claims;
+    std::uint64_t verified_claims;
+    std::uint64_t active_sales;
+    eosio::asset reward_volume; // Rewards paid for verified claims
+
+    std::uint64_t primary_key() const { return community.raw(); }
+
+    EOSLIB_SERIALIZE(aggregate,
+                     (community)(members)(objectives)
+                     (open_claims)(verified_claims)
+                     (active_sales)(reward_volume));
+  };
+
+  TABLE aggregate_cursor {
+    eosio::symbol community;
+    std::uint8_t phase;
+    std::uint64_t last_id; // Last row visited in the current phase, 0 when starting it
+    bespiral::aggregate counted;
+
+    std::uint64_t primary_key() const { return community.raw(); }
+
+    EOSLIB_SERIALIZE(aggregate_cursor,
+                     (community)(phase)(last_id)(counted));
+  };
+
+  // Claims and checks erased by `reclaim`, added up per action
+  TABLE claim_summary {
+    std::uint64_t action_id;
+    eosio::symbol community;
+    std::uint64_t verified_claims;
+    std::uint64_t rejected_claims; // Closed without reaching the verifications needed
+    std::uint64_t checks;
+    eosio::asset reward_volume;
+
+    std::uint64_t primary_key() const { return action_id; }
+    std::uint64_t by_cmm() const { return community.raw(); }
+
+    EOSLIB_SERIALIZE(claim_summary,
+                     (action_id)(community)(verified_claims)
+                     (rejected_claims)(checks)(reward_volume));
+  };
+
+  // Resumable maintenance job, see utils/jobs.hpp
+  TABLE job {
+    std::uint64_t id;
+    eosio::name type;
+    std::uint64_t argument; // Community symbol for `rebuildagg` and `closeacts`, last legacy claim id for `reindexclaim`,
+                            // objective or action id for `delobjective` and `delaction`
+    std::uint64_t cursor;
+    std::uint64_t processed;
+    std::uint8_t is_done;
+
+    std::uint64_t primary_key() const { return id; }
+
+    EOSLIB_SERIALIZE(job,
+                     (id)(type)(argument)(cursor)
+                     (processed)(is_done));
+  };
+
+  TABLE reclaim_cursor {
+    std::uint8_t phase;    // 0 claims and checks, 1 validators of deleted actions
+    std::uint64_t next_id; // First row not visited yet in the current phase
+  };
+
+  // One vote of `verifyclaims`
+  struct claim_vote {
+    std::uint64_t claim_id;
+    std::uint8_t vote;
+
+    EOSLIB_SERIALIZE(claim_vote, (claim_id)(vote));
+  };
+
+  // State shared by the votes of one verifier within a transaction
+  struct vote_batch {
+    std::map<std::uint64_t, eosio::symbol> action_communities; // Actions whose validators and community were checked
+    std::vector<eosio::asset> verifier_rewards;                // One per symbol
+
+    void add_verifier_reward(const eosio::asset &reward) {
+      for (auto &r : verifier_rewards) {
+        if (r.symbol == reward.symbol) {
+          r += reward;
+          return;
+        }
+      }
+      verifier_rewards.push_back(reward);
+    }
   };
 
   /// @abi action
@@ -160,6 +413,10 @@ class [[eosio::contract("bespiral.community")]] bespiral : public eosio::contrac
   /// Adds a user to a community
   ACTION netlink(eosio::asset cmm_asset, eosio::name inviter, eosio::name new_user);
 
+  /// @abi action
+  /// Set the share of the inviter reward paid to the inviters above the direct one, level by level
+  ACTION setreferral(eosio::symbol community_symbol, std::vector<std::uint16_t> level_rates);
+
   /// @abi action
   /// Create a new community objective
   ACTION newobjective(eosio::asset cmm_asset, std::string description, eosio::name creator);
@@ -176,16 +433,25 @@ class [[eosio::contract("bespiral.community")]] bespiral : public eosio::contrac
                       std::uint64_t usages, std::uint64_t usages_left,
                       std::uint64_t verifications, std::string verification_type,
                       std::string validators_str, std::uint8_t is_completed,
-                      eosio::name creator);
+                      eosio::name creator,
+                      eosio::binary_extension<std::uint64_t> max_open_claims);
 
   /// @abi action
   /// Start a new claim on an action
   ACTION claimaction(std::uint64_t action_id, eosio::name maker);
 
+  /// @abi action
+  /// Limit how many claims a user can open within `window` seconds, 0 disables it
+  ACTION setthrottle(std::uint32_t window, std::uint32_t max_claims);
+
   /// @abi action
   /// Send a vote verification for a given claim. It has to be `claimable` verification_type
   ACTION verifyclaim(std::uint64_t claim_id, eosio::name verifier, std::uint8_t vote);
 
+  /// @abi action
+  /// Send several votes of the same verifier, applied in order
+  ACTION verifyclaims(eosio::name verifier, std::vector<claim_vote> votes);
+
   /// @abi action
   /// Verify that a given action was completed. It has to have the `automatic` verification_type
   ACTION verifyaction(std::uint64_t action_id, eosio::name maker, eosio::name verifier);
@@ -202,6 +468,22 @@ class [[eosio::contract("bespiral.community")]] bespiral : public eosio::contrac
                     std::string description, eosio::asset quantity,
                     std::string image, std::uint8_t track_stock, std::uint64_t units);
 
+  /// @abi action
+  /// Offer to buy up to `units` from the stock tracked sales of `seller` priced at `price` or less
+  ACTION newbuyorder(eosio::name buyer, eosio::name seller, eosio::asset price, std::uint64_t units);
+
+  /// @abi action
+  /// Withdraw a buy order of a community
+  ACTION cancelorder(eosio::symbol community_symbol, std::uint64_t order_id);
+
+  /// @abi action
+  /// Pay for the units held by an order fill
+  ACTION acceptfill(std::uint64_t fill_id);
+
+  /// @abi action
+  /// Give the units held by an order fill back to its sale, by the buyer or the seller
+  ACTION rejectfill(std::uint64_t fill_id);
+
   /// @abi action
   /// Delete a sale
   ACTION deletesale(std::uint64_t sale_id);
@@ -218,11 +500,105 @@ class [[eosio::contract("bespiral.community")]] bespiral : public eosio::contrac
 	/// Set the indices for a chain
 	ACTION setindices(std::uint64_t sale_id, std::uint64_t objective_id, std::uint64_t action_id, std::uint64_t claim_id);
 
+  /// @abi action
+  /// Erase an action row only, its claims and validators are left to `reclaim`. A `delaction` job erases them all
   ACTION deleteact(std::uint64_t id);
 
+  /// @abi action
+  /// Close up to `max_rows` actions of a community whose deadline has passed
+  ACTION closeactions(eosio::symbol community_symbol, std::uint64_t max_rows);
+
+  /// @abi action
+  /// Recompute the aggregates of a community, visiting at most `max_rows` rows per call
+  ACTION rebuildagg(eosio::symbol community_symbol, std::uint64_t max_rows);
+
+  /// @abi action
+  /// Erase up to `max_rows` finished claims, their checks and the validators of deleted actions
+  ACTION reclaim(std::uint64_t max_rows);
+
+  /// @abi action
+  /// Queue a maintenance job: `rebuildagg`, `reclaim`, `reindexclaim`, `indexacts`, `closeacts`,
+  /// `netpaths`, `delaction` or `delobjective`
+  ACTION addjob(eosio::name type, std::uint64_t argument);
+
+  /// @abi action
+  /// Run the next slice of a job, processing at most `max_rows` rows
+  ACTION runjob(std::uint64_t id, std::uint64_t max_rows);
+
+  /// @abi action
+  /// Export up to `max_rows` packed rows of a table starting at `from_id`, within `bulk::max_page_bytes`, sent as a `rowspage` action
+  ACTION exportrows(eosio::name table, std::uint64_t scope, std::uint64_t from_id, std::uint64_t max_rows);
+
+  /// @abi action
+  /// A page of exported rows, `next_id` is where the next page starts or 0 after the last one
+  ACTION rowspage(eosio::name table, std::uint64_t scope, std::uint64_t next_id, bulk::packed_rows rows);
+
+  /// @abi action
+  /// Emplace packed rows, as exported by `exportrows`
+  ACTION importrows(eosio::name table, std::uint64_t scope, bulk::packed_rows rows);
+
+  // Open claims counters and throttle used by claimaction
+  void add_open_claim(eosio::name claimer, std::uint64_t action_id);
+  void release_open_claim(eosio::name claimer, std::uint64_t action_id);
+  void throttle_claims(eosio::name claimer);
+  jobs::slice reindex_claims(std::uint64_t from_id, std::uint64_t last_id, std::uint64_t max_rows);
+
+  // Hold units of a sale for the best buy orders on its seller
+  void match_buy_orders(std::uint64_t sale_id);
+  bool can_pay(eosio::name buyer, const eosio::asset &quantity);
+
+  // Erase an objective or action with everything under them, they return true once it is gone
+  bool teardown_objective(std::uint64_t objective_id, std::uint64_t &budget);
+  bool teardown_action(std::uint64_t action_id, std::uint64_t &budget);
+
+  // Referral paths, see `network`
+  std::vector<eosio::name> network_ancestors(const bespiral::network &member);
+  void count_in_ancestors(eosio::symbol community_symbol, const std::vector<eosio::name> &ancestors);
+  jobs::slice index_network(std::uint64_t from_id, std::uint64_t max_rows);
+
+  // Active actions index, see `active_action`
+  void sync_active_action(const bespiral::action &act, eosio::symbol community_symbol);
+  jobs::slice close_expired_actions(eosio::symbol community_symbol, std::uint64_t max_rows);
+  jobs::slice index_actions(std::uint64_t from_id, std::uint64_t max_rows);
+
+  void apply_vote(std::uint64_t claim_id, eosio::name verifier, std::uint8_t vote, vote_batch &batch);
+  void send_verifier_rewards(eosio::name verifier, const vote_batch &batch);
+
   //Get available key
   uint64_t get_available_id(std::string table);
 
+  // Store a text field inline, releasing the blob it had before if any
+  void set_text(std::string &field, eosio::binary_extension<std::uint64_t> &handle, const std::string &value);
+  // Store a text that repeats across rows, moving long values to the blobs table and keeping only a handle on the row
+  void set_shared_text(std::string &field, eosio::binary_extension<std::uint64_t> &handle, const std::string &value);
+  void release_text(const eosio::binary_extension<std::uint64_t> &handle);
+  std::uint64_t acquire_blob(const std::string &data);
+  void release_blob(std::uint64_t blob_id);
+
+  // Update the aggregates row of a community, creating it if needed
+  template <typename Lambda>
+  void update_aggregate(eosio::symbol community_symbol, Lambda &&updater);
+
+  // Aggregate rebuild phases, they return true once the phase is done
+  template <typename Table, typename Index, typename Lambda>
+  bool rebuild_rows(Table &table, Index &index, aggregate_cursor &cursor,
+                    std::uint64_t &budget, Lambda &&count);
+  bool rebuild_claims(aggregate_cursor &cursor, std::uint64_t &budget);
+  bool rebuild_aggregate(eosio::symbol community_symbol, std::uint64_t &budget);
+
+  // Reclaim phases, they return true once the phase is done. A pass runs both of them
+  bool reclaim_pass(std::uint64_t &budget);
+  bool reclaim_claims(reclaim_cursor &cursor, std::uint64_t &budget);
+  bool reclaim_validators(reclaim_cursor &cursor, std::uint64_t &budget);
+
+  // Update the summary row of an action, creating it if needed. Returns the action community
+  template <typename Lambda>
+  eosio::symbol update_claim_summary(const bespiral::action &act, Lambda &&updater);
+
+  // Call `f` with the table of the given name, for bulk export and import
+  template <typename Lambda>
+  void with_table(eosio::name table, std::uint64_t scope, Lambda &&f);
+
 
   typedef eosio::multi_index<eosio::name{"community"}, bespiral::community> communities;
   typedef eosio::multi_index<eosio::name{"network"},
@@ -231,6 +607,8 @@ class [[eosio::contract("bespiral.community")]] bespiral : public eosio::contrac
                                                eosio::const_mem_fun<bespiral::network, uint64_t, &bespiral::network::users_by_cmm>>
                              > networks;
 
+  typedef eosio::multi_index<eosio::name{"referrals"}, bespiral::referral_config> referral_configs;
+
   typedef eosio::multi_index<eosio::name{"objective"},
                              bespiral::objective,
                              eosio::indexed_by<eosio::name{"bycmm"},
@@ -243,6 +621,12 @@ class [[eosio::contract("bespiral.community")]] bespiral : public eosio::contrac
                                                eosio::const_mem_fun<bespiral::action, uint64_t, &bespiral::action::by_objective>>
                              > actions;
 
+  typedef eosio::multi_index<eosio::name{"activeacts"},
+                             bespiral::active_action,
+                             eosio::indexed_by<eosio::name{"bycmmdl"},
+                                               eosio::const_mem_fun<bespiral::active_action, uint128_t, &bespiral::active_action::by_cmm_deadline>>
+                             > active_actions;
+
   typedef eosio::multi_index<eosio::name{"validator"},
                              bespiral::action_validator,
                              eosio::indexed_by<eosio::name{"byaction"},
@@ -252,7 +636,11 @@ class [[eosio::contract("bespiral.community")]] bespiral : public eosio::contrac
   typedef eosio::multi_index<eosio::name{"claim"},
                              bespiral::claim,
                              eosio::indexed_by<eosio::name{"byaction"},
-                                               eosio::const_mem_fun<bespiral::claim, uint64_t, &bespiral::claim::by_action>>
+                                               eosio::const_mem_fun<bespiral::claim, uint64_t, &bespiral::claim::by_action>>,
+                             eosio::indexed_by<eosio::name{"byclaimer"},
+                                               eosio::const_mem_fun<bespiral::claim, uint64_t, &bespiral::claim::by_claimer>>,
+                             eosio::indexed_by<eosio::name{"byactclaimer"},
+                                               eosio::const_mem_fun<bespiral::claim, uint128_t, &bespiral::claim::by_action_claimer>>
                              > claims;
 
   typedef eosio::multi_index<eosio::name{"check"},
@@ -267,6 +655,34 @@ class [[eosio::contract("bespiral.community")]] bespiral : public eosio::contrac
                              eosio::indexed_by<eosio::name{"byuser"}, eosio::const_mem_fun<bespiral::sale, uint64_t, &bespiral::sale::by_user>>
                             > sales;
 
+  typedef eosio::multi_index<eosio::name{"buyorders"},
+                             bespiral::buy_order,
+                             eosio::indexed_by<eosio::name{"bysellprice"}, eosio::const_mem_fun<bespiral::buy_order, uint128_t, &bespiral::buy_order::by_seller_price>>
+                            > buy_orders;
+
+  typedef eosio::multi_index<eosio::name{"orderfills"}, bespiral::order_fill> order_fills;
+
+  typedef eosio::multi_index<eosio::name{"blobs"},
+                             bespiral::blob,
+                             eosio::indexed_by<eosio::name{"byhash"}, eosio::const_mem_fun<bespiral::blob, eosio::checksum256, &bespiral::blob::by_hash>>
+                            > blobs;
+
+  typedef eosio::multi_index<eosio::name{"aggregates"}, bespiral::aggregate> aggregates;
+  typedef eosio::multi_index<eosio::name{"aggcursor"}, bespiral::aggregate_cursor> aggregate_cursors;
+
+  typedef eosio::multi_index<eosio::name{"claimsummary"},
+                             bespiral::claim_summary,
+                             eosio::indexed_by<eosio::name{"bycmm"}, eosio::const_mem_fun<bespiral::claim_summary, uint64_t, &bespiral::claim_summary::by_cmm>>
+                            > claim_summaries;
+
+  typedef eosio::multi_index<eosio::name{"jobs"}, bespiral::job> maintenance_jobs;
+
+  typedef eosio::singleton<eosio::name{"reclaimcur"}, bespiral::reclaim_cursor> reclaim_cursors;
+
+  typedef eosio::multi_index<eosio::name{"openclaims"}, bespiral::open_claim_count> open_claim_counts;
+  typedef eosio::multi_index<eosio::name{"throttle"}, bespiral::claim_throttle> claim_throttles;
+  typedef eosio::singleton<eosio::name{"throttlecfg"}, bespiral::throttle_config> throttle_configs;
+
   typedef eosio::singleton<eosio::name{"indexes"}, bespiral::indexes> item_indexes;
 
   item_indexes curr_indexes;
@@ -275,6 +691,15 @@ class [[eosio::contract("bespiral.community")]] bespiral : public eosio::contrac
   bespiral(eosio::name receiver, eosio::name code, eosio::datastream<const char *> ds) : contract(receiver, code, ds), curr_indexes(_self, _self.value) {}
 };
 
+// Keep the read views used by bespiral.token in sync with our rows
+static_assert(std::is_same<decltype(views::community_v1::symbol), decltype(bespiral::community::symbol)>::value &&
+              std::is_same<decltype(views::community_v1::creator), decltype(bespiral::community::creator)>::value,
+              "views::community_v1 must match the leading fields of bespiral::community");
+static_assert(std::is_same<decltype(views::network_v1::id), decltype(bespiral::network::id)>::value &&
+              std::is_same<decltype(views::network_v1::community), decltype(bespiral::network::community)>::value &&
+              std::is_same<decltype(views::network_v1::invited_user), decltype(bespiral::network::invited_user)>::value,
+              "views::network_v1 must match the leading fields of bespiral::network");
+
 const auto currency_account = eosio::name{"bes.token"};
 struct currency_stats {
   eosio::asset supply;
@@ -286,3 +711,12 @@ struct currency_stats {
   uint64_t primary_key() const { return supply.symbol.code().raw(); }
 };
 typedef eosio::multi_index<eosio::name{"stat"}, currency_stats> bespiral_tokens;
+
+struct currency_balance {
+  eosio::asset balance;
+
+  uint64_t primary_key() const { return balance.symbol.code().raw(); }
+
+  EOSLIB_SERIALIZE(currency_balance, (balance));
+};
+typedef eosio::multi_index<eosio::name{"accounts"}, currency_balance> bespiral_balances;
@@ -1,5 +1,5 @@
 #include "bespiral.token.hpp"
-#include "../utils/utils.cpp"
+#include "../utils/utils.hpp"
 
 /**
    Creates a BeSpiral token.
@@ -111,6 +111,12 @@ void token::update(eosio::asset max_supply, eosio::asset min_balance) {
    You can choose to send the newly minted tokens to a specific account.
  */
 void token::issue(eosio::name to, eosio::asset quantity, std::string memo) {
+  issue_tokens(to, quantity, memo);
+}
+
+void token::issue_tokens(eosio::name to, eosio::asset quantity, std::string_view memo) {
+  BES_TRACE_ACTION("issue");
+
   eosio::symbol sym = quantity.symbol;
   eosio_assert(sym.is_valid(), "invalid symbol name");
   eosio_assert(memo.size() <= 256, "memo has more than 256 bytes");
@@ -135,19 +141,30 @@ void token::issue(eosio::name to, eosio::asset quantity, std::string memo) {
                                });
 
   add_balance(st.issuer, quantity, st);
+  record_transfer(st.issuer, _self, quantity, 1, memo);
+
+  update_daily(sym, [&](auto& d) { d.issued += quantity; });
 
   if (to != st.issuer) {
     require_recipient(st.issuer);
 
-    SEND_INLINE_ACTION(*this,
-                       transfer,
-                       { _self, eosio::name{"active"}},
-                       { st.issuer, to, quantity, memo}
-    );
+    eosio::action transfer_action;
+    transfer_action.account = _self;
+    transfer_action.name = eosio::name{"transfer"};
+    transfer_action.authorization.emplace_back(_self, eosio::name{"active"});
+    transfer_action.data = args::pack(st.issuer, to, quantity, memo);
+    transfer_action.send();
+    BES_COUNT(inline_sends);
   }
 }
 
 void token::transfer(eosio::name from, eosio::name to, eosio::asset quantity, std::string memo) {
+  transfer_tokens(from, to, quantity, memo);
+}
+
+void token::transfer_tokens(eosio::name from, eosio::name to, eosio::asset quantity, std::string_view memo) {
+  BES_TRACE_ACTION("transfer");
+
   eosio_assert(from != to, "cannot transfer to self");
 
   // Require auth from self or from contract
@@ -184,11 +201,18 @@ void token::transfer(eosio::name from, eosio::name to, eosio::asset quantity, st
   // Transfer values
   sub_balance(from, quantity, st);
   add_balance(to, quantity, st);
+  record_transfer(from, to, quantity, -1, memo);
+  record_transfer(to, from, quantity, 1, memo);
+
+  update_daily(sym, [&](auto& d) {
+                      d.transfers++;
+                      d.transfer_volume += quantity;
+                    });
 
   // Schedule retirement
   if (st.type == "expiry") {
     token::expiry_options opts = get_expiration_opts(st);
-    std::string memo = "Your tokens expired! You need to use them within " + std::to_string(opts.expiration_period) + " seconds!";
+    std::string memo = "Your tokens expired! You need to use them within " + uint64_to_str(opts.expiration_period) + " seconds!";
     eosio::transaction retire_transaction{};
     retire_transaction.actions.emplace_back(eosio::permission_level{_self, eosio::name{"active"}}, // Permission
                                             _self, // Account
@@ -207,6 +231,8 @@ void token::transfer(eosio::name from, eosio::name to, eosio::asset quantity, st
   It removes a certain quantity of tokens out of the circulation if the owner doesn't use it
  */
 void token::retire(eosio::name from, eosio::asset quantity, std::string memo) {
+  BES_TRACE_ACTION("retire");
+
   require_auth(_self);
 
   auto sym = quantity.symbol;
@@ -247,6 +273,8 @@ void token::retire(eosio::name from, eosio::asset quantity, std::string memo) {
   statstable.modify(st, _self, [&]( auto& s ) {
                                  s.supply -= quantity;
                                });
+
+  update_daily(sym, [&](auto& d) { d.retired += quantity; });
 }
 
 void token::initacc(eosio::symbol currency, eosio::name account) {
@@ -264,18 +292,194 @@ void token::initacc(eosio::symbol currency, eosio::name account) {
   auto itr_net = network.find(network_id);
   eosio_assert(itr_net != network.end(), "account doesn't belong to the community");
 
-  // Create account table entry
-  accounts accounts(_self, account.value);
-  auto found_account = accounts.find(currency.code().raw());
+  init_account(account, st);
+}
 
-  if (found_account == accounts.end()) {
-    accounts.emplace(_self, [&](auto& a) {
-                              a.balance = eosio::asset(0, st.supply.symbol);
-                              a.last_activity = now();
+/**
+   Open a balance epoch.
+   @version 1.0
+
+   From now on the first change to each balance saves the balance it replaces in `checkpoints`,
+   so balances at the opening of the epoch stay readable, for token weighted polls. Only the
+   balances that change are saved. Epochs are numbered from 1 and kept in `epochs` with the time
+   they were opened.
+*/
+void token::openepoch(eosio::symbol currency) {
+  eosio_assert(currency.is_valid(), "invalid symbol name");
+
+  stats statstable(_self, currency.code().raw());
+  const auto& st = statstable.get(currency.code().raw(), "token with given symbol does not exist");
+  eosio_assert(currency == st.supply.symbol, "symbol precision mismatch");
+
+  // Only the token issuer can open epochs
+  require_auth(st.issuer);
+
+  std::uint64_t epoch = st.epoch.value_or(0) + 1;
+  statstable.modify(st, _self, [&](auto& s) { s.epoch.emplace(epoch); });
+
+  balance_epochs epochs(_self, currency.code().raw());
+  epochs.emplace(_self, [&](auto& e) {
+                          e.id = epoch;
+                          e.opened_at = now();
+                        });
+}
+
+/**
+   Keep the last transfers of an account.
+   @version 1.0
+
+   While kept, every transfer and issue of `currency` the account takes part in is saved on its
+   row of `recent`, which holds the last `recent_ring_size` of them, so wallets can show the
+   latest transactions with a single row read. Stopping erases the row.
+*/
+void token::keeprecent(eosio::name owner, eosio::symbol currency, bool keep) {
+  require_auth(owner);
+
+  eosio_assert(currency.is_valid(), "invalid symbol name");
+
+  stats statstable(_self, currency.code().raw());
+  const auto& st = statstable.get(currency.code().raw(), "token with given symbol does not exist");
+  eosio_assert(currency == st.supply.symbol, "symbol precision mismatch");
+
+  recent_transfer_rings rings(_self, owner.value);
+  auto ring = rings.find(currency.code().raw());
+
+  if (keep) {
+    eosio_assert(ring == rings.end(), "recent transfers are already kept");
+    rings.emplace(owner, [&](auto& r) {
+                           r.currency = currency.code();
+                           r.next = 0;
+                           r.transfers.resize(recent_ring_size);
+                         });
+  } else {
+    eosio_assert(ring != rings.end(), "recent transfers are not kept");
+    rings.erase(ring);
+  }
+}
+
+/**
+   Audit the supply of a token.
+   @version 1.0
+
+   Checks that the balances of a token add up to its supply. Each call adds the balances of the
+   next `max_rows` members of the token community to the audit row of the token, in `audits`,
+   walking the community network by community and then id, and the call that reaches the last
+   member adds the issuer's balance and compares the total with the supply. A mismatch is printed and left on the row. The next call after that starts a
+   new audit. Transfers, issues and retirements between calls are taken into account.
+*/
+void token::audit(eosio::symbol currency, std::uint64_t max_rows) {
+  eosio_assert(currency.is_valid(), "invalid symbol name");
+  eosio_assert(max_rows > 0, "max_rows must be greater than 0");
+
+  stats statstable(_self, currency.code().raw());
+  const auto& st = statstable.get(currency.code().raw(), "token with given symbol does not exist");
+  eosio_assert(currency == st.supply.symbol, "symbol precision mismatch");
+
+  // Require auth from the issuer or the contract
+  if (has_auth(st.issuer)) {
+    require_auth(st.issuer);
+  } else {
+    require_auth(_self);
+  }
+
+  // Members of the token community, in id order
+  bespiral_networks network(community_account, community_account.value);
+  auto members = network.get_index<eosio::name{"usersbycmm"}>();
+  auto in_community = [&](auto member) { return member != members.end() && member->community == currency; };
+
+  auto first = members.lower_bound(currency.raw());
+  auto start = [&](auto& a) {
+                 a.currency = currency;
+                 a.cursor = in_community(first) ? first->id : 0;
+                 a.accounts = 0;
+                 a.balances = eosio::asset(0, currency);
+                 a.supply = eosio::asset(0, currency);
+                 a.started_at = now();
+                 a.is_done = 0;
+               };
+
+  supply_audits audits(_self, _self.value);
+  auto itr = audits.find(currency.code().raw());
+  if (itr == audits.end()) {
+    itr = audits.emplace(_self, start);
+  } else if (itr->is_done) {
+    audits.modify(itr, _self, start);
+  }
+
+  auto balance_of = [&](eosio::name owner) {
+                      accounts accounts(_self, owner.value);
+                      auto found = accounts.find(currency.code().raw());
+                      return found == accounts.end() ? 0 : found->balance.amount;
+                    };
+
+  std::uint64_t counted = 0;
+  std::int64_t balances = 0;
+
+  // Resume at the member the last call stopped at, network rows are never erased
+  auto stopped_at = network.find(itr->cursor);
+  auto member = stopped_at == network.end() ? members.end() : members.iterator_to(*stopped_at);
+  for (std::uint64_t rows = 0; in_community(member) && rows < max_rows; member++, rows++) {
+    if (member->invited_user != st.issuer) {
+      balances += balance_of(member->invited_user);
+      counted++;
+    }
+  }
+
+  bool done = !in_community(member);
+  std::uint64_t cursor = done ? itr->cursor : member->id;
+  if (done) {
+    balances += balance_of(st.issuer);
+    counted++;
+  }
+
+  audits.modify(itr, _self, [&](auto& a) {
+                              a.cursor = cursor;
+                              a.accounts += counted;
+                              a.balances.amount += balances;
+                              if (done) {
+                                a.supply = st.supply;
+                                a.is_done = 1;
+                              }
                             });
+
+  if (done && itr->balances != itr->supply) {
+    eosio::print("supply audit mismatch: balances add up to ", itr->balances, " but the supply is ", itr->supply);
   }
 }
 
+/**
+   Queue a maintenance job.
+   @version 1.0
+
+   `initaccs` walks the members of the token community and runs `initacc` for every one of them
+   that has no balance yet.
+*/
+void token::addjob(eosio::name type, std::uint64_t argument) {
+  require_auth(_self);
+
+  eosio_assert(type == eosio::name{"initaccs"}, "Job type must be 'initaccs'");
+
+  eosio::symbol currency(argument);
+  stats statstable(_self, currency.code().raw());
+  statstable.get(currency.code().raw(), "token with given symbol does not exist");
+
+  maintenance_jobs job(_self, _self.value);
+  jobs::add(job, _self, type, argument);
+}
+
+void token::runjob(std::uint64_t id, std::uint64_t max_rows) {
+  require_auth(_self);
+
+  maintenance_jobs job(_self, _self.value);
+  jobs::run(job, _self, id, max_rows, [&](const auto& j, std::uint64_t max_rows) {
+      eosio::symbol currency(j.argument);
+      stats statstable(_self, currency.code().raw());
+      const auto& st = statstable.get(currency.code().raw(), "token with given symbol does not exist");
+
+      return init_accounts(st, j.cursor, max_rows);
+    });
+}
+
 
 void token::setexpiry(eosio::symbol currency, std::uint32_t expiration_period, eosio::asset renovation_amount) {
   // Validate data
@@ -312,12 +516,16 @@ void token::setexpiry(eosio::symbol currency, std::uint32_t expiration_period, e
 }
 
 void token::sub_balance(eosio::name owner, eosio::asset value, const token::currency_stats& st) {
+  BES_COUNT(rows_written);
+
   eosio_assert(value.is_valid(), "Invalid value");
   eosio_assert(value.amount > 0, "Can only transfer positive values");
 
   // Check for existing balance
   token::accounts accounts(_self, owner.value);
   auto from = accounts.find(value.symbol.code().raw());
+  std::uint64_t epoch = checkpoint_balance(owner, from == accounts.end() ? nullptr : &*from, st);
+  audit_balance(owner, -value.amount, st);
 
   // MCC
   if (st.type == "mcc") {
@@ -329,6 +537,7 @@ void token::sub_balance(eosio::name owner, eosio::asset value, const token::curr
                                 a.balance = value;
                                 a.balance.amount *= -1;
                                 a.last_activity = now();
+                                if (epoch > 0) a.checkpoint_epoch.emplace(epoch);
                               });
     } else {
       auto new_balance = from->balance.amount - value.amount;
@@ -336,6 +545,7 @@ void token::sub_balance(eosio::name owner, eosio::asset value, const token::curr
       accounts.modify(from, _self, [&](auto& a) {
                                      a.balance.amount -= value.amount;
                                      a.last_activity = now();
+                                     if (epoch > 0) a.checkpoint_epoch.emplace(epoch);
                                    });
     }
     return;
@@ -348,31 +558,212 @@ void token::sub_balance(eosio::name owner, eosio::asset value, const token::curr
     accounts.modify(from, _self, [&](auto& a) {
                                    a.balance -= value;
                                    a.last_activity = now();
+                                   if (epoch > 0) a.checkpoint_epoch.emplace(epoch);
                                  });
     return;
   }
 }
 
 void token::add_balance(eosio::name recipient, eosio::asset value, const token::currency_stats& st) {
+  BES_COUNT(rows_written);
+
   eosio_assert(value.is_valid(), "Invalid value");
   eosio_assert(value.amount > 0, "Can only transfer positive values");
 
   accounts accounts(_self, recipient.value);
   auto to = accounts.find(value.symbol.code().raw());
+  std::uint64_t epoch = checkpoint_balance(recipient, to == accounts.end() ? nullptr : &*to, st);
+  audit_balance(recipient, value.amount, st);
 
   if (to == accounts.end()) {
     accounts.emplace(_self, [&](auto& a) {
                               a.balance = value;
                               a.last_activity = now();
+                              if (epoch > 0) a.checkpoint_epoch.emplace(epoch);
                             });
   } else {
     accounts.modify(to, _self, [&](auto& a) {
                                  a.balance += value;
                                  a.last_activity = now();
+                                 if (epoch > 0) a.checkpoint_epoch.emplace(epoch);
                                });
   }
 }
 
+/*
+  Saves the balance `account` holds before its first change in the current epoch, a missing
+  account holding 0. Returns the epoch to stamp the account with, or 0 when there is nothing to save.
+ */
+std::uint64_t token::checkpoint_balance(eosio::name owner, const token::account* account, const token::currency_stats& st) {
+  std::uint64_t epoch = st.epoch.value_or(0);
+  if (epoch == 0 || (account != nullptr && account->checkpoint_epoch.value_or(0) == epoch))
+    return 0;
+
+  balance_checkpoints checkpoints(_self, st.supply.symbol.code().raw());
+  checkpoints.emplace(_self, [&](auto& c) {
+                               c.id = checkpoints.available_primary_key();
+                               c.owner = owner;
+                               c.epoch = epoch;
+                               c.balance = account != nullptr ? account->balance : eosio::asset(0, st.supply.symbol);
+                             });
+  BES_COUNT(rows_written);
+
+  return epoch;
+}
+
+/*
+  Keeps a running supply audit right when the balance of `owner` changes by `change`:
+  balances it already added are updated, the others are read when the audit gets to them
+ */
+void token::audit_balance(eosio::name owner, std::int64_t change, const token::currency_stats& st) {
+  supply_audits audits(_self, _self.value);
+  auto audit = audits.find(st.supply.symbol.code().raw());
+  if (audit == audits.end() || audit->is_done || owner == st.issuer)
+    return;
+
+  // Only members the walk already passed, it goes by id within the community
+  if (gen_uuid(st.supply.symbol.raw(), owner.value) >= audit->cursor)
+    return;
+
+  audits.modify(audit, _self, [&](auto& a) { a.balances.amount += change; });
+  BES_COUNT(rows_written);
+}
+
+/*
+  Saves a transfer on the recent transfers ring of `owner`, if it keeps one.
+  `sign` is -1 for tokens sent and 1 for tokens received
+ */
+void token::record_transfer(eosio::name owner, eosio::name counterparty, eosio::asset quantity, std::int64_t sign, std::string_view memo) {
+  recent_transfer_rings rings(_self, owner.value);
+  auto ring = rings.find(quantity.symbol.code().raw());
+  if (ring == rings.end())
+    return;
+
+  capi_checksum256 digest;
+  sha256(memo.data(), memo.size(), &digest);
+
+  recent_transfer entry;
+  entry.counterparty = counterparty;
+  entry.amount = sign * quantity.amount;
+  entry.time = now();
+  std::memcpy(&entry.memo_hash, digest.hash, sizeof(entry.memo_hash));
+
+  rings.modify(ring, owner, [&](auto& r) {
+                              r.transfers[r.next] = entry;
+                              r.next = (r.next + 1) % recent_ring_size;
+                            });
+  BES_COUNT(rows_written);
+}
+
+/**
+   Export the rows of a table for a chain migration.
+   @version 1.0
+
+   Rows are sent packed on an inline `rowspage` action, where history nodes keep them. A page holds
+   at most `max_rows` rows and stops earlier at `bulk::max_page_bytes`, to fit the inline action
+   size limit. Pass its `next_id` as `from_id` to get the next page, until it is 0. Balances are scoped by owner,
+   stats, daily activity, epochs and checkpoints by symbol code, recent transfers by owner and expiry
+   options and audits by the contract account.
+*/
+void token::exportrows(eosio::name table, std::uint64_t scope, std::uint64_t from_id, std::uint64_t max_rows) {
+  require_auth(_self);
+
+  eosio_assert(max_rows > 0, "max_rows must be greater than 0");
+
+  bulk::packed_rows rows;
+  std::uint64_t next_id = 0;
+  with_table(table, scope, [&](auto& t) { next_id = bulk::export_page(t, from_id, max_rows, rows); });
+
+  SEND_INLINE_ACTION(*this,
+                     rowspage,
+                     { _self, eosio::name{"active"}},
+                     { table, scope, next_id, rows }
+  );
+}
+
+void token::rowspage(eosio::name table, std::uint64_t scope, std::uint64_t next_id, bulk::packed_rows rows) {
+  require_auth(_self);
+}
+
+/**
+   Import rows exported from another chain.
+   @version 1.0
+
+   Rows are stored as they are, without any validation.
+*/
+void token::importrows(eosio::name table, std::uint64_t scope, bulk::packed_rows rows) {
+  require_auth(_self);
+
+  with_table(table, scope, [&](auto& t) { bulk::import_page(t, _self, rows); });
+}
+
+template <typename Lambda>
+void token::with_table(eosio::name table, std::uint64_t scope, Lambda&& f) {
+  if (table == eosio::name{"accounts"}) {
+    accounts t(_self, scope);
+    f(t);
+  } else if (table == eosio::name{"stat"}) {
+    stats t(_self, scope);
+    f(t);
+  } else if (table == eosio::name{"expiryopts"}) {
+    expiry_opts t(_self, scope);
+    f(t);
+  } else if (table == eosio::name{"daily"}) {
+    daily_activities t(_self, scope);
+    f(t);
+  } else if (table == eosio::name{"epochs"}) {
+    balance_epochs t(_self, scope);
+    f(t);
+  } else if (table == eosio::name{"checkpoints"}) {
+    balance_checkpoints t(_self, scope);
+    f(t);
+  } else if (table == eosio::name{"recent"}) {
+    recent_transfer_rings t(_self, scope);
+    f(t);
+  } else if (table == eosio::name{"audits"}) {
+    supply_audits t(_self, scope);
+    f(t);
+  } else {
+    eosio_assert(false, "Table must be some of: 'accounts', 'stat', 'expiryopts', 'daily', 'epochs', 'checkpoints', 'recent' or 'audits'");
+  }
+}
+
+void token::init_account(eosio::name account, const token::currency_stats& st) {
+  // Create account table entry
+  accounts accounts(_self, account.value);
+  auto found_account = accounts.find(st.supply.symbol.code().raw());
+
+  if (found_account == accounts.end()) {
+    accounts.emplace(_self, [&](auto& a) {
+                              a.balance = eosio::asset(0, st.supply.symbol);
+                              a.last_activity = now();
+                            });
+  }
+}
+
+// Members of the token community in id order, `from_id` is the next member to visit or 0 for the first
+jobs::slice token::init_accounts(const token::currency_stats& st, std::uint64_t from_id, std::uint64_t max_rows) {
+  jobs::slice result{from_id, 0, false};
+
+  bespiral_networks network(community_account, community_account.value);
+  auto members = network.get_index<eosio::name{"usersbycmm"}>();
+  auto in_community = [&](auto member) { return member != members.end() && member->community == st.supply.symbol; };
+
+  // Resume at the member the last call stopped at, network rows are never erased
+  auto member = members.lower_bound(st.supply.symbol.raw());
+  if (from_id != 0) {
+    auto stopped_at = network.find(from_id);
+    member = stopped_at == network.end() ? members.end() : members.iterator_to(*stopped_at);
+  }
+
+  for (; in_community(member) && result.rows < max_rows; member++, result.rows++)
+    init_account(member->invited_user, st);
+
+  result.done = !in_community(member);
+  if (!result.done) result.cursor = member->id;
+  return result;
+}
+
 /*
   Gets the configuration for a given community. If it doesn't have any, it uses the contract default
  */
@@ -397,7 +788,55 @@ token::expiry_options token::get_expiration_opts(const token::currency_stats& st
   return expiry_struct;
 }
 
-EOSIO_DISPATCH(token,
-               (create)(update)(issue)
-               (transfer)(retire)(setexpiry)
-               (initacc));
+/*
+  Updates today's bucket on the daily activity ring of a symbol.
+  Buckets are reused every `daily_ring_size` days, so the table never grows past that many rows per symbol
+ */
+template <typename Lambda>
+void token::update_daily(eosio::symbol sym, Lambda&& updater) {
+  std::uint32_t today = now() / 86400;
+
+  daily_activities daily(_self, sym.code().raw());
+  auto bucket = daily.find(today % daily_ring_size);
+
+  auto reset = [&](auto& d) {
+                 d.day = today;
+                 d.transfers = 0;
+                 d.transfer_volume = eosio::asset(0, sym);
+                 d.issued = eosio::asset(0, sym);
+                 d.retired = eosio::asset(0, sym);
+               };
+
+  if (bucket == daily.end()) {
+    daily.emplace(_self, [&](auto& d) {
+                           reset(d);
+                           updater(d);
+                         });
+  } else {
+    daily.modify(bucket, _self, [&](auto& d) {
+                                  if (d.day != today) reset(d);
+                                  updater(d);
+                                });
+  }
+}
+
+extern "C" {
+  void apply(uint64_t receiver, uint64_t code, uint64_t action) {
+    if (code != receiver) return;
+
+    switch (action) {
+      // Hot actions, their memos are checked in place
+      case eosio::name("transfer").value:
+        args::execute(receiver, code, &token::transfer_tokens);
+        break;
+      case eosio::name("issue").value:
+        args::execute(receiver, code, &token::issue_tokens);
+        break;
+
+      EOSIO_DISPATCH_HELPER(token,
+                            (create)(update)(retire)
+                            (setexpiry)(initacc)(openepoch)(keeprecent)(audit)(addjob)(runjob)
+                            (exportrows)(rowspage)(importrows))
+    }
+  }
+}
@@ -2,6 +2,19 @@
 #include <eosiolib/asset.hpp>
 #include <eosiolib/transaction.hpp>
 #include <eosiolib/system.h>
+#include <eosiolib/binary_extension.hpp>
+
+#include "../utils/views.hpp"
+#include "../utils/trace.hpp"
+#include "../utils/jobs.hpp"
+#include "../utils/bulk.hpp"
+#include "../utils/args.hpp"
+
+// Days of token activity kept per symbol
+const std::uint32_t daily_ring_size = 90;
+
+// Transfers kept on the recent transfers ring of an account
+const std::uint32_t recent_ring_size = 20;
 
 class [[eosio::contract("bespiral.token")]] token : public eosio::contract {
  public:
@@ -11,10 +24,11 @@ class [[eosio::contract("bespiral.token")]] token : public eosio::contract {
   TABLE account {
     eosio::asset balance;
     uint32_t last_activity;
+    eosio::binary_extension<std::uint64_t> checkpoint_epoch; // Last epoch its balance was checkpointed in
 
     uint64_t primary_key() const { return balance.symbol.code().raw(); }
 
-    EOSLIB_SERIALIZE(account, (balance)(last_activity));
+    EOSLIB_SERIALIZE(account, (balance)(last_activity)(checkpoint_epoch));
   };
 
   TABLE currency_stats {
@@ -23,10 +37,11 @@ class [[eosio::contract("bespiral.token")]] token : public eosio::contract {
     eosio::asset min_balance;
     eosio::name issuer;
     std::string type;
+    eosio::binary_extension<std::uint64_t> epoch; // Current balance epoch, 0 or missing before the first one
 
     uint64_t primary_key() const { return supply.symbol.code().raw(); }
 
-    EOSLIB_SERIALIZE(currency_stats, (supply)(max_supply)(min_balance)(issuer)(type));
+    EOSLIB_SERIALIZE(currency_stats, (supply)(max_supply)(min_balance)(issuer)(type)(epoch));
   };
 
   TABLE expiry_options {
@@ -39,6 +54,107 @@ class [[eosio::contract("bespiral.token")]] token : public eosio::contract {
     EOSLIB_SERIALIZE(expiry_options, (currency)(expiration_period)(renovation_amount));
   };
 
+  // One bucket of the daily activity ring, stored on slot `day % daily_ring_size`
+  TABLE daily_activity {
+    std::uint32_t day; // Days since epoch, a bucket with an older day is stale
+    std::uint64_t transfers;
+    eosio::asset transfer_volume;
+    eosio::asset issued;
+    eosio::asset retired;
+
+    uint64_t primary_key() const { return day % daily_ring_size; }
+
+    EOSLIB_SERIALIZE(daily_activity, (day)(transfers)(transfer_volume)(issued)(retired));
+  };
+
+  // Balance epoch of a token, scoped by symbol code
+  TABLE balance_epoch {
+    std::uint64_t id;
+    std::uint32_t opened_at;
+
+    uint64_t primary_key() const { return id; }
+
+    EOSLIB_SERIALIZE(balance_epoch, (id)(opened_at));
+  };
+
+  /*
+    Balance of `owner` when `epoch` opened, saved before its first change within that epoch.
+    Scoped by symbol code. The balance at the opening of epoch E is the one of the owner's
+    first checkpoint with an epoch of E or later, or the current balance if there is none.
+   */
+  TABLE balance_checkpoint {
+    std::uint64_t id;
+    eosio::name owner;
+    std::uint64_t epoch;
+    eosio::asset balance;
+
+    uint64_t primary_key() const { return id; }
+    uint128_t by_owner_epoch() const { return (uint128_t(owner.value) << 64) | epoch; }
+
+    EOSLIB_SERIALIZE(balance_checkpoint, (id)(owner)(epoch)(balance));
+  };
+
+  // Entry of a recent transfers ring, `amount` is negative for tokens sent
+  struct recent_transfer {
+    eosio::name counterparty; // The token contract itself for issued tokens
+    std::int64_t amount;
+    std::uint32_t time;
+    std::uint32_t memo_hash; // First bytes of the sha256 of the memo
+
+    EOSLIB_SERIALIZE(recent_transfer, (counterparty)(amount)(time)(memo_hash));
+  };
+
+  /*
+    Last `recent_ring_size` transfers of an account, for the accounts that asked for them with
+    `keeprecent`. Scoped by owner, who pays for the row. It is created with every entry empty, a 0
+    `time`, and each transfer overwrites the one at `next`, so the oldest entry is at `next` and the
+    newest right before it. The row never changes size, transfers signed by others don't bill the owner.
+   */
+  TABLE recent_transfers {
+    eosio::symbol_code currency;
+    std::uint8_t next;
+    std::vector<recent_transfer> transfers;
+
+    uint64_t primary_key() const { return currency.raw(); }
+
+    EOSLIB_SERIALIZE(recent_transfers, (currency)(next)(transfers));
+  };
+
+  /*
+    Running supply audit of a token, scoped by the contract account. The balances of the token
+    community members with an id below `cursor`, the next member to count, are summed on
+    `balances`, and kept up to date as they change, so the sum stays right while the audit is
+    spread over many calls.
+    The issuer is counted last, it may not be a member. `supply` is saved when the audit is done.
+   */
+  TABLE supply_audit {
+    eosio::symbol currency;
+    std::uint64_t cursor;
+    std::uint64_t accounts;
+    eosio::asset balances;
+    eosio::asset supply;
+    std::uint32_t started_at;
+    std::uint8_t is_done;
+
+    uint64_t primary_key() const { return currency.code().raw(); }
+
+    EOSLIB_SERIALIZE(supply_audit, (currency)(cursor)(accounts)(balances)(supply)(started_at)(is_done));
+  };
+
+  // Resumable maintenance job, see utils/jobs.hpp
+  TABLE job {
+    std::uint64_t id;
+    eosio::name type;
+    std::uint64_t argument; // Token symbol for `initaccs`
+    std::uint64_t cursor;
+    std::uint64_t processed;
+    std::uint8_t is_done;
+
+    uint64_t primary_key() const { return id; }
+
+    EOSLIB_SERIALIZE(job, (id)(type)(argument)(cursor)(processed)(is_done));
+  };
+
   /// @abi action
   /// Create a new BeSpiral Token
   ACTION create(eosio::name issuer, eosio::asset max_supply, eosio::asset min_balance, std::string type);
@@ -67,39 +183,75 @@ class [[eosio::contract("bespiral.token")]] token : public eosio::contract {
   /// Init empty balance for a given account
   ACTION initacc(eosio::symbol currency, eosio::name account);
 
+  /// @abi action
+  /// Open a new balance epoch, balances at its opening can be read back once it is over
+  ACTION openepoch(eosio::symbol currency);
+
+  /// @abi action
+  /// Start or stop keeping the last transfers of an account in `recent`
+  ACTION keeprecent(eosio::name owner, eosio::symbol currency, bool keep);
+
+  /// @abi action
+  /// Add up to `max_rows` members' balances to the supply audit of a token, starting a new one if the last is done
+  ACTION audit(eosio::symbol currency, std::uint64_t max_rows);
+
+  /// @abi action
+  /// Queue a maintenance job: `initaccs` creates the empty balances of every community member
+  ACTION addjob(eosio::name type, std::uint64_t argument);
+
+  /// @abi action
+  /// Run the next slice of a job, processing at most `max_rows` rows
+  ACTION runjob(std::uint64_t id, std::uint64_t max_rows);
+
+  /// @abi action
+  /// Export up to `max_rows` packed rows of a table starting at `from_id`, within `bulk::max_page_bytes`, sent as a `rowspage` action
+  ACTION exportrows(eosio::name table, std::uint64_t scope, std::uint64_t from_id, std::uint64_t max_rows);
+
+  /// @abi action
+  /// A page of exported rows, `next_id` is where the next page starts or 0 after the last one
+  ACTION rowspage(eosio::name table, std::uint64_t scope, std::uint64_t next_id, bulk::packed_rows rows);
+
+  /// @abi action
+  /// Emplace packed rows, as exported by `exportrows`
+  ACTION importrows(eosio::name table, std::uint64_t scope, bulk::packed_rows rows);
+
   typedef eosio::multi_index< eosio::name{"accounts"}, account > accounts;
   typedef eosio::multi_index< eosio::name{"stat"}, currency_stats > stats;
   typedef eosio::multi_index< eosio::name{"expiryopts"}, expiry_options > expiry_opts;
+  typedef eosio::multi_index< eosio::name{"daily"}, daily_activity > daily_activities;
+  typedef eosio::multi_index< eosio::name{"jobs"}, job > maintenance_jobs;
+  typedef eosio::multi_index< eosio::name{"epochs"}, balance_epoch > balance_epochs;
+  typedef eosio::multi_index< eosio::name{"checkpoints"},
+                              balance_checkpoint,
+                              eosio::indexed_by<eosio::name{"byownerepoch"},
+                                                eosio::const_mem_fun<balance_checkpoint, uint128_t, &balance_checkpoint::by_owner_epoch>>
+                              > balance_checkpoints;
+  typedef eosio::multi_index< eosio::name{"recent"}, recent_transfers > recent_transfer_rings;
+  typedef eosio::multi_index< eosio::name{"audits"}, supply_audit > supply_audits;
+
+  // Bodies of transfer and issue, dispatched with the memo left on the action data, see utils/args.hpp
+  void transfer_tokens(eosio::name from, eosio::name to, eosio::asset quantity, std::string_view memo);
+  void issue_tokens(eosio::name to, eosio::asset quantity, std::string_view memo);
 
   void sub_balance(eosio::name owner, eosio::asset value, const token::currency_stats& st);
   void add_balance(eosio::name owner, eosio::asset value, const token::currency_stats& st);
+  void init_account(eosio::name account, const token::currency_stats& st);
+  std::uint64_t checkpoint_balance(eosio::name owner, const token::account* account, const token::currency_stats& st);
+  void audit_balance(eosio::name owner, std::int64_t change, const token::currency_stats& st);
+  void record_transfer(eosio::name owner, eosio::name counterparty, eosio::asset quantity, std::int64_t sign, std::string_view memo);
+  jobs::slice init_accounts(const token::currency_stats& st, std::uint64_t from_id, std::uint64_t max_rows);
   void renovate_expiration(eosio::name account, const token::currency_stats& st);
 
   token::expiry_options get_expiration_opts(const token::currency_stats& st);
-};
-
-const auto community_account = eosio::name{"bes.cmm"};
-struct community {
-  eosio::symbol symbol;
 
-  eosio::name creator;
-  std::string logo;
-  std::string title;
-  std::string description;
-  eosio::asset inviter_reward;
-  eosio::asset invited_reward;
+  // Call `f` with the table of the given name, for bulk export and import
+  template <typename Lambda>
+  void with_table(eosio::name table, std::uint64_t scope, Lambda&& f);
 
-  std::uint64_t primary_key() const { return symbol.raw(); }
+  template <typename Lambda>
+  void update_daily(eosio::symbol sym, Lambda&& updater);
 };
-typedef eosio::multi_index<eosio::name{"community"}, community> bespiral_communities;
-
-struct network {
-  std::uint64_t id;
 
-  eosio::symbol community;
-  eosio::name invited_user;
-  eosio::name invited_by;
-
-  std::uint64_t primary_key() const { return id; }
-};
-typedef eosio::multi_index<eosio::name{"network"}, network> bespiral_networks;
+const auto community_account = eosio::name{"bes.cmm"};
+typedef views::communities_v1 bespiral_communities;
+typedef views::networks_v1 bespiral_networks;
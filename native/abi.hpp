@@ -0,0 +1,301 @@
+#pragma once
+
+#include "json.hpp"
+
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/asset.hpp>
+
+#include <cstring>
+#include <deque>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace eosio { namespace native {
+
+  /**
+     Decoding of packed table rows and action data driven by a contract ABI, without the
+     contract types. Values are written as text: numbers, names, symbols and assets in their
+     usual form, structs and arrays as JSON.
+  */
+
+  /// Type tree compiled from the ABI once per type, so decoding a value does no lookups
+  struct type_node {
+    enum kind_t { builtin, array, optional, extension, structure } kind = builtin;
+    std::string builtin_name;
+    const type_node* inner = nullptr;
+    std::vector<std::pair<std::string, const type_node*>> fields;
+  };
+
+  struct abi_def {
+    std::map<std::string, std::string> typedefs;
+    std::map<std::string, std::pair<std::string, std::vector<std::pair<std::string, std::string>>>> structs;
+    std::map<std::string, std::string> tables;  // Table name to row type
+    std::map<std::string, std::string> actions; // Action name to data type
+
+    std::deque<type_node> nodes;
+    std::map<std::string, const type_node*> compiled;
+
+    const type_node* compile(const std::string& type, int depth = 0) {
+      if (depth > 32)
+        throw std::runtime_error("abi type " + type + " is too deeply nested");
+
+      auto found = compiled.find(type);
+      if (found != compiled.end())
+        return found->second;
+
+      type_node node;
+      char suffix = type.empty() ? 0 : type.back();
+      if (type.size() > 2 && type.compare(type.size() - 2, 2, "[]") == 0) {
+        node.kind = type_node::array;
+        node.inner = compile(type.substr(0, type.size() - 2), depth + 1);
+      } else if (suffix == '?' || suffix == '$') {
+        node.kind = suffix == '?' ? type_node::optional : type_node::extension;
+        node.inner = compile(type.substr(0, type.size() - 1), depth + 1);
+      } else if (typedefs.count(type)) {
+        return compiled[type] = compile(typedefs.at(type), depth + 1);
+      } else if (structs.count(type)) {
+        node.kind = type_node::structure;
+        const auto& def = structs.at(type);
+        if (!def.first.empty())
+          node.fields = compile(def.first, depth + 1)->fields;
+        for (const auto& field : def.second)
+          node.fields.emplace_back(field.first, compile(field.second, depth + 1));
+      } else if (is_builtin(type)) {
+        node.builtin_name = type;
+      } else {
+        throw std::runtime_error("unknown abi type " + type);
+      }
+
+      nodes.push_back(std::move(node));
+      return compiled[type] = &nodes.back();
+    }
+
+    static bool is_builtin(const std::string& type) {
+      static const std::set<std::string> builtins = {
+        "bool", "int8", "uint8", "int16", "uint16", "int32", "uint32", "int64", "uint64",
+        "int128", "uint128", "varint32", "varuint32", "float32", "float64", "name", "string",
+        "bytes", "symbol", "symbol_code", "asset", "extended_asset", "checksum160", "checksum256",
+        "checksum512", "time_point", "time_point_sec", "block_timestamp_type"
+      };
+      return builtins.count(type) > 0;
+    }
+  };
+
+  inline abi_def load_abi(const std::string& content) {
+    json_reader reader(content.data(), content.data() + content.size());
+    json doc = reader.next();
+    abi_def abi;
+
+    if (const json* types = doc.find("types")) {
+      for (const auto& t : types->items)
+        abi.typedefs[t.find("new_type_name")->as_string()] = t.find("type")->as_string();
+    }
+
+    for (const auto& s : doc.find("structs")->items) {
+      auto& def = abi.structs[s.find("name")->as_string()];
+      def.first = s.find("base") ? s.find("base")->text : "";
+      for (const auto& f : s.find("fields")->items)
+        def.second.emplace_back(f.find("name")->as_string(), f.find("type")->as_string());
+    }
+
+    for (const auto& t : doc.find("tables")->items)
+      abi.tables[t.find("name")->as_string()] = t.find("type")->as_string();
+
+    if (const json* actions = doc.find("actions")) {
+      for (const auto& a : actions->items)
+        abi.actions[a.find("name")->as_string()] = a.find("type")->as_string();
+    }
+
+    return abi;
+  }
+
+  struct truncated_row : std::runtime_error {
+    truncated_row() : std::runtime_error("row data ends early") {}
+  };
+
+  /// Reads packed data in place and appends the text of each value to `out`, collecting the names it reads in `names`
+  class row_decoder {
+  public:
+    row_decoder(const char* begin, const char* end, std::vector<name>* names = nullptr)
+      : _pos(begin), _end(end), _names(names) {}
+
+    bool at_end() const { return _pos >= _end; }
+
+    // `quoted` is set inside JSON values, where strings and names need quotes
+    void value(const type_node* type, std::string& out, bool quoted) {
+      switch (type->kind) {
+      case type_node::builtin:
+        builtin(type->builtin_name, out, quoted);
+        return;
+      case type_node::array: {
+        uint32_t size = varuint32();
+        out += '[';
+        for (uint32_t i = 0; i < size; i++) {
+          if (i > 0) out += ',';
+          value(type->inner, out, true);
+        }
+        out += ']';
+        return;
+      }
+      case type_node::optional:
+        if (read<uint8_t>())
+          value(type->inner, out, quoted);
+        else if (quoted)
+          out += "null";
+        return;
+      case type_node::extension:
+        if (!at_end())
+          value(type->inner, out, quoted);
+        else if (quoted)
+          out += "null";
+        return;
+      case type_node::structure:
+        out += '{';
+        for (size_t i = 0; i < type->fields.size(); i++) {
+          if (type->fields[i].second->kind == type_node::extension && at_end())
+            break;
+          if (i > 0) out += ',';
+          quote(type->fields[i].first, out);
+          out += ':';
+          value(type->fields[i].second, out, true);
+        }
+        out += '}';
+        return;
+      }
+    }
+
+  private:
+    template<typename T>
+    T read() {
+      if (_end - _pos < ptrdiff_t(sizeof(T)))
+        throw truncated_row();
+      T value;
+      std::memcpy(&value, _pos, sizeof(T));
+      _pos += sizeof(T);
+      return value;
+    }
+
+    uint32_t varuint32() {
+      uint32_t value = 0;
+      for (int shift = 0; shift < 35; shift += 7) {
+        uint8_t b = read<uint8_t>();
+        value |= uint32_t(b & 0x7f) << shift;
+        if (!(b & 0x80))
+          return value;
+      }
+      throw std::runtime_error("varuint32 is too long");
+    }
+
+    const char* bytes(uint32_t size) {
+      if (uint64_t(_end - _pos) < size)
+        throw truncated_row();
+      const char* begin = _pos;
+      _pos += size;
+      return begin;
+    }
+
+    static void hex(const char* data, size_t size, std::string& out) {
+      static const char digits[] = "0123456789abcdef";
+      for (size_t i = 0; i < size; i++) {
+        out += digits[uint8_t(data[i]) >> 4];
+        out += digits[uint8_t(data[i]) & 0xf];
+      }
+    }
+
+    static void u128(unsigned __int128 value, std::string& out) {
+      char buffer[40];
+      char* p = buffer + sizeof(buffer);
+      do {
+        *--p = '0' + int(value % 10);
+        value /= 10;
+      } while (value);
+      out.append(p, buffer + sizeof(buffer) - p);
+    }
+
+    static void quote(const std::string& str, std::string& out) {
+      out += '"';
+      escape(str.data(), str.size(), out);
+      out += '"';
+    }
+
+    // Column files hold one value per line, so line breaks are escaped outside of JSON as well
+    static void escape(const char* data, size_t size, std::string& out, bool quoted = true) {
+      for (size_t i = 0; i < size; i++) {
+        char c = data[i];
+        if ((c == '"' && quoted) || c == '\\') { out += '\\'; out += c; }
+        else if (c == '\n') out += "\\n";
+        else if (c == '\r') out += "\\r";
+        else if (c == '\t') out += "\\t";
+        else out += c;
+      }
+    }
+
+    void text(const std::string& str, std::string& out, bool quoted) {
+      if (quoted) quote(str, out);
+      else out += str;
+    }
+
+    void builtin(const std::string& type, std::string& out, bool quoted) {
+      if (type == "bool") out += read<uint8_t>() ? "true" : "false";
+      else if (type == "int8") out += std::to_string(read<int8_t>());
+      else if (type == "uint8") out += std::to_string(read<uint8_t>());
+      else if (type == "int16") out += std::to_string(read<int16_t>());
+      else if (type == "uint16") out += std::to_string(read<uint16_t>());
+      else if (type == "int32") out += std::to_string(read<int32_t>());
+      else if (type == "uint32" || type == "time_point_sec" || type == "block_timestamp_type")
+        out += std::to_string(read<uint32_t>());
+      else if (type == "int64" || type == "time_point") out += std::to_string(read<int64_t>());
+      else if (type == "uint64") out += std::to_string(read<uint64_t>());
+      else if (type == "uint128") u128(read<unsigned __int128>(), out);
+      else if (type == "int128") {
+        __int128 value = read<__int128>();
+        if (value < 0) out += '-';
+        u128(value < 0 ? -(unsigned __int128)value : value, out);
+      }
+      else if (type == "varuint32") out += std::to_string(varuint32());
+      else if (type == "varint32") {
+        uint32_t zigzag = varuint32();
+        out += std::to_string(int32_t(zigzag >> 1) ^ -int32_t(zigzag & 1));
+      }
+      else if (type == "float32") out += std::to_string(read<float>());
+      else if (type == "float64") out += std::to_string(read<double>());
+      else if (type == "name") {
+        name value{read<uint64_t>()};
+        if (_names) _names->push_back(value);
+        text(value.to_string(), out, quoted);
+      }
+      else if (type == "symbol") text(symbol{read<uint64_t>()}.to_string(), out, quoted);
+      else if (type == "symbol_code") text(symbol_code{read<uint64_t>()}.to_string(), out, quoted);
+      else if (type == "asset") {
+        int64_t amount = read<int64_t>();
+        text(asset{amount, symbol{read<uint64_t>()}}.to_string(), out, quoted);
+      }
+      else if (type == "extended_asset") {
+        int64_t amount = read<int64_t>();
+        std::string str = asset{amount, symbol{read<uint64_t>()}}.to_string();
+        text(str + "@" + name{read<uint64_t>()}.to_string(), out, quoted);
+      }
+      else if (type == "string") {
+        uint32_t size = varuint32();
+        const char* data = bytes(size);
+        if (quoted) out += '"';
+        escape(data, size, out, quoted);
+        if (quoted) out += '"';
+      }
+      else {
+        size_t size = type == "checksum160" ? 20 : type == "checksum256" ? 32 : type == "checksum512" ? 64 : varuint32();
+        if (quoted) out += '"';
+        hex(bytes(size), size, out);
+        if (quoted) out += '"';
+      }
+    }
+
+    const char* _pos;
+    const char* _end;
+    std::vector<name>* _names;
+  };
+
+}} // namespace eosio::native
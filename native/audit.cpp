@@ -0,0 +1,276 @@
+#include "chain.hpp"
+#include "../bespiral.token/bespiral.token.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+   Checks that the balances of every token add up to its supply over long runs of simulated
+   operations, through the contract's own `audit` action.
+
+   The chain is either seeded with an `mcc` and an `expiry` token with `--accounts` members each,
+   or loaded from a snapshot saved by `replay --save`, to audit a copy of production. Then `--ops`
+   random transfers, issues and retirements are pushed, and every `--every` operations the audit
+   of each token advances by `--rows` members, so audits always run across moving balances.
+   Every audit the contract completes is checked twice: its own result, and against the sum of
+   all the balance rows of the token read directly from the chain.
+
+   Usage: audit [--state snapshot] [--accounts n] [--ops n] [--every n] [--rows n] [--seed n]
+*/
+
+using eosio::asset;
+using eosio::name;
+using eosio::symbol;
+using eosio::native::chain;
+
+namespace {
+
+  const name community_contract{"bes.cmm"};
+  const name token_contract{"bes.token"};
+  const name founder{"founder"};
+
+  const symbol mcc_symbol{"BES", 4};
+  const symbol expiry_symbol{"EXP", 4};
+
+  // Account names made of a prefix letter and five base 26 digits
+  name account_name(char prefix, uint64_t index) {
+    char str[7] = { prefix };
+    for (int i = 5; i > 0; i--) {
+      str[i] = 'a' + index % 26;
+      index /= 26;
+    }
+    return name{std::string_view(str, 6)};
+  }
+
+  struct audited_token {
+    symbol sym;
+    name issuer;
+    std::string type;
+    std::vector<name> members;
+    uint64_t audits = 0;
+    uint64_t mismatches = 0;
+  };
+
+  class simulation {
+  public:
+    simulation(uint64_t seed, uint64_t rows) : _random(seed), _rows(rows) {
+      _chain.set_time(1546300800);
+      _chain.deploy(community_contract, "./bespiral.community.so");
+      _chain.deploy(token_contract, "./bespiral.token.so");
+    }
+
+    void seed(uint64_t accounts) {
+      _chain.create_account(founder);
+      for (auto sym : { mcc_symbol, expiry_symbol }) {
+        std::string type = sym == mcc_symbol ? "mcc" : "expiry";
+        push_or_die(community_contract, name{"create"}, founder,
+                    asset(0, sym), founder, std::string("logo"), type,
+                    std::string("Audited community"), asset(0, sym), asset(0, sym));
+        push_or_die(token_contract, name{"create"}, founder,
+                    founder, asset(4000000000000000000, sym), asset(type == "mcc" ? -1000000 : 0, sym), type);
+      }
+
+      for (uint64_t i = 0; i < accounts; i++) {
+        _chain.create_account(account_name('m', i));
+        for (auto sym : { mcc_symbol, expiry_symbol })
+          push_or_die(community_contract, name{"netlink"}, founder, asset(0, sym), founder, account_name('m', i));
+      }
+
+      load_tokens(_chain.take_snapshot());
+    }
+
+    void restore(const std::string& path) {
+      std::ifstream in(path, std::ios::binary);
+      if (!in)
+        throw std::runtime_error("unable to open " + path);
+      auto state = chain::snapshot::load(in);
+      _chain.accept_any_account(true);
+      load_tokens(state);
+      _chain.restore_snapshot(std::move(state));
+    }
+
+    // Pushes `ops` random operations, advancing the audits every `every` of them
+    void run(uint64_t ops, uint64_t every) {
+      uint64_t rejected = 0;
+      auto start = std::chrono::steady_clock::now();
+
+      for (uint64_t op = 0; op < ops; op++) {
+        if (op % every == 0) {
+          for (auto& t : _tokens)
+            advance_audit(t);
+        }
+
+        _chain.advance_time(1);
+        auto& t = _tokens[_random() % _tokens.size()];
+        if (t.members.size() < 2)
+          continue;
+
+        try {
+          random_operation(t);
+        } catch (const eosio::native::assertion_failure&) {
+          rejected++; // Overdrawn balances and the like, rolled back
+        }
+      }
+
+      // Let the running audits finish on the final state
+      for (auto& t : _tokens) {
+        uint64_t audits = t.audits;
+        while (t.audits == audits)
+          advance_audit(t);
+      }
+
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      std::printf("%llu operations, %llu rejected, in %.2f s, %.0f ops/s\n", (unsigned long long)ops,
+                  (unsigned long long)rejected, seconds, ops / std::max(seconds, 1e-9));
+      std::printf("%-8s %-7s %10s %10s %12s\n", "token", "type", "members", "audits", "mismatches");
+      for (const auto& t : _tokens) {
+        std::printf("%-8s %-7s %10zu %10llu %12llu\n", t.sym.code().to_string().c_str(), t.type.c_str(), t.members.size(),
+                    (unsigned long long)t.audits, (unsigned long long)t.mismatches);
+      }
+    }
+
+    bool consistent() const {
+      for (const auto& t : _tokens)
+        if (t.mismatches > 0) return false;
+      return true;
+    }
+
+  private:
+    template<typename... Args>
+    void push_or_die(name account, name action_name, name actor, Args&&... args) {
+      try {
+        _chain.push(account, action_name, actor, std::forward<Args>(args)...);
+      } catch (const std::exception& e) {
+        std::fprintf(stderr, "seeding %s failed: %s\n", action_name.to_string().c_str(), e.what());
+        std::exit(1);
+      }
+    }
+
+    // Every token on the stats table, with the members of its community
+    void load_tokens(const chain::snapshot& state) {
+      std::map<uint64_t, size_t> by_code;
+      for (const auto& t : state.tables) {
+        if (t.first.code != token_contract.value || t.first.table != name{"stat"}.value)
+          continue;
+        for (const auto& r : t.second) {
+          auto st = eosio::unpack<token::currency_stats>(r.second.data);
+          by_code[st.supply.symbol.code().raw()] = _tokens.size();
+          _tokens.push_back({ st.supply.symbol, st.issuer, st.type });
+        }
+      }
+
+      chain::table_key network_key{ community_contract.value, community_contract.value, name{"network"}.value };
+      auto network = state.tables.find(network_key);
+      if (network == state.tables.end())
+        return;
+      for (const auto& r : network->second) {
+        auto member = eosio::unpack<views::network_v1>(r.second.data);
+        auto found = by_code.find(member.community.code().raw());
+        if (found != by_code.end())
+          _tokens[found->second].members.push_back(member.invited_user);
+      }
+    }
+
+    void random_operation(audited_token& t) {
+      name from = t.members[_random() % t.members.size()];
+      name to = t.members[_random() % t.members.size()];
+      int64_t amount = 1 + _random() % 1000;
+      uint64_t kind = _random() % 100;
+
+      if (kind < 70) {
+        if (from == to) return;
+        _chain.push(token_contract, name{"transfer"}, from, from, to, asset(amount, t.sym), std::string("audit"));
+      } else if (kind < 85 || t.type != "expiry") {
+        _chain.push(token_contract, name{"issue"}, t.issuer, to, asset(amount, t.sym), std::string("audit"));
+      } else {
+        _chain.push(token_contract, name{"retire"}, token_contract, from, asset(amount, t.sym), std::string("audit"));
+      }
+    }
+
+    void advance_audit(audited_token& t) {
+      _chain.push(token_contract, name{"audit"}, token_contract, t.sym, _rows);
+
+      const auto* data = _chain.get_row(token_contract, token_contract.value, name{"audits"}, t.sym.code().raw());
+      if (data == nullptr)
+        throw std::runtime_error("audit row of " + t.sym.code().to_string() + " is missing");
+      auto audit = eosio::unpack<token::supply_audit>(*data);
+      if (!audit.is_done)
+        return;
+
+      t.audits++;
+      int64_t balances = sum_balances(t.sym);
+      if (audit.balances == audit.supply && audit.balances.amount == balances)
+        return;
+
+      t.mismatches++;
+      std::printf("%s audit %llu: contract sums %lld against a supply of %lld, the balance rows add up to %lld\n",
+                  t.sym.code().to_string().c_str(), (unsigned long long)t.audits, (long long)audit.balances.amount,
+                  (long long)audit.supply.amount, (long long)balances);
+    }
+
+    // Balance rows of every scope, whether the owner is a member or not
+    int64_t sum_balances(symbol sym) const {
+      int64_t sum = 0;
+      auto state = _chain.take_snapshot();
+      for (const auto& t : state.tables) {
+        if (t.first.code != token_contract.value || t.first.table != name{"accounts"}.value)
+          continue;
+        auto row = t.second.find(sym.code().raw());
+        if (row != t.second.end())
+          sum += eosio::unpack<token::account>(row->second.data).balance.amount;
+      }
+      return sum;
+    }
+
+    chain _chain;
+    std::mt19937_64 _random;
+    uint64_t _rows;
+    std::vector<audited_token> _tokens;
+  };
+
+}
+
+int main(int argc, char** argv) {
+  std::string state_path;
+  uint64_t accounts = 1000, ops = 1000000, every = 10, rows = 50, seed = 1;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "--state" && has_value) state_path = argv[++i];
+    else if (arg == "--accounts" && has_value) accounts = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--ops" && has_value) ops = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--every" && has_value) every = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--rows" && has_value) rows = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--seed" && has_value) seed = std::strtoull(argv[++i], nullptr, 10);
+    else {
+      std::fprintf(stderr, "usage: audit [--state snapshot] [--accounts n] [--ops n] [--every n] [--rows n] [--seed n]\n");
+      return 1;
+    }
+  }
+
+  if (every == 0 || rows == 0) {
+    std::fprintf(stderr, "--every and --rows must be greater than 0\n");
+    return 1;
+  }
+
+  try {
+    simulation sim(seed, rows);
+    if (state_path.empty())
+      sim.seed(accounts);
+    else
+      sim.restore(state_path);
+
+    sim.run(ops, every);
+    return sim.consistent() ? 0 : 2;
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "audit failed: %s\n", e.what());
+    return 1;
+  }
+}
@@ -0,0 +1,266 @@
+#include "chain.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+   Micro-benchmark of the contract actions on the native chain.
+
+   For every table size given on the command line a fresh chain is seeded with that many
+   community members, open claims and checks, then each action is pushed `reps` times and
+   reported with its average wall time and database work per call.
+
+   Usage: bench [-r reps] [size...]
+*/
+
+using eosio::asset;
+using eosio::name;
+using eosio::symbol;
+using eosio::native::chain;
+
+namespace {
+
+  const name community_contract{"bes.cmm"};
+  const name token_contract{"bes.token"};
+  const name founder{"founder"};
+  const name validator_one{"valone"};
+  const name validator_two{"valtwo"};
+
+  const uint64_t votes_per_batch = 5;
+
+  const symbol community_symbol{"BES", 4};
+  const symbol expiry_symbol{"EXP", 4};
+
+  // Account names made of a prefix letter and five base 26 digits
+  name account_name(char prefix, uint64_t index) {
+    char str[7] = { prefix };
+    for (int i = 5; i > 0; i--) {
+      str[i] = 'a' + index % 26;
+      index /= 26;
+    }
+    return name{std::string_view(str, 6)};
+  }
+
+  // Community symbols for `create`, three to seven uppercase letters
+  symbol community_code(uint64_t index) {
+    char str[8] = { 'C', 'M' };
+    int size = 2;
+    do {
+      str[size++] = 'A' + index % 26;
+      index /= 26;
+    } while (index > 0 && size < 7);
+    return symbol{std::string_view(str, size), 4};
+  }
+
+  struct claim_vote {
+    uint64_t claim_id;
+    uint8_t vote;
+  };
+
+  struct result {
+    double micros = 0;
+    chain::op_counters ops;
+    std::string error;
+  };
+
+  class bench {
+  public:
+    bench(uint64_t size, uint32_t reps) : _size(size), _reps(reps) {
+      _chain.set_time(1546300800);
+      for (auto account : { founder, validator_one, validator_two })
+        _chain.create_account(account);
+      _chain.deploy(community_contract, "./bespiral.community.so");
+      _chain.deploy(token_contract, "./bespiral.token.so");
+
+      seed();
+    }
+
+    void run() {
+      measure("create", [&](uint64_t i) {
+          _chain.push(community_contract, name{"create"}, founder,
+                      asset(0, community_code(i)), founder, std::string("logo"), std::string("Community"),
+                      std::string("Benchmark community"), asset(0, community_code(i)), asset(0, community_code(i)));
+        });
+
+      for (uint64_t i = 0; i < _reps; i++)
+        _chain.create_account(account_name('n', i));
+      measure("netlink", [&](uint64_t i) {
+          _chain.push(community_contract, name{"netlink"}, founder,
+                      asset(0, community_symbol), founder, account_name('n', i));
+        });
+
+      measure("upsertaction", [&](uint64_t) {
+          _chain.push(community_contract, name{"upsertaction"}, founder,
+                      uint64_t(0), uint64_t(1), std::string("Benchmark action"),
+                      asset(10, community_symbol), asset(1, community_symbol), uint64_t(0),
+                      uint64_t(0), uint64_t(0), uint64_t(2), std::string("claimable"),
+                      std::string("founder-valone-valtwo"), uint8_t(0), founder);
+        });
+
+      measure("claimaction", [&](uint64_t i) {
+          _chain.push(community_contract, name{"claimaction"}, member(i), uint64_t(1), member(i));
+        });
+
+      // Oldest claims first, their checks are the furthest away from the end of the table
+      measure("verifyclaim", [&](uint64_t i) {
+          _chain.push(community_contract, name{"verifyclaim"}, validator_two, i + 1, validator_two, uint8_t(1));
+        });
+
+      // Claims after the ones verified above, one batch per call
+      measure("verifyclaims", [&](uint64_t i) {
+          std::vector<claim_vote> votes;
+          for (uint64_t v = 0; v < votes_per_batch; v++)
+            votes.push_back({ _reps + i * votes_per_batch + v + 1, 1 });
+          _chain.push(community_contract, name{"verifyclaims"}, validator_two, validator_two, votes);
+        });
+
+      measure("createsale", [&](uint64_t i) {
+          _chain.push(community_contract, name{"createsale"}, member(i),
+                      member(i), std::string("Sale"), std::string("Benchmark sale"),
+                      asset(10, community_symbol), std::string("image"), uint8_t(1), uint64_t(1000));
+        });
+
+      measure("transfersale", [&](uint64_t i) {
+          _chain.push(community_contract, name{"transfersale"}, member(i + 1),
+                      i + 1, member(i + 1), member(i), asset(10, community_symbol), uint64_t(1));
+        });
+
+      measure("issue", [&](uint64_t i) {
+          _chain.push(token_contract, name{"issue"}, founder,
+                      member(i), asset(10, community_symbol), std::string("issue"));
+        });
+
+      measure("transfer", [&](uint64_t i) {
+          _chain.push(token_contract, name{"transfer"}, member(i),
+                      member(i), member(i + 1), asset(1, community_symbol), std::string("transfer"));
+        });
+
+      for (uint64_t i = 0; i < _reps; i++)
+        push_or_die(token_contract, name{"issue"}, founder, member(i), asset(10, expiry_symbol), std::string("issue"));
+      measure("retire", [&](uint64_t i) {
+          _chain.push(token_contract, name{"retire"}, token_contract,
+                      member(i), asset(10, expiry_symbol), std::string("retire"));
+        });
+    }
+
+  private:
+    name member(uint64_t index) const { return account_name('m', index % _size); }
+
+    template<typename... Args>
+    void push_or_die(name account, name action_name, name actor, Args&&... args) {
+      try {
+        _chain.push(account, action_name, actor, std::forward<Args>(args)...);
+      } catch (const std::exception& e) {
+        std::fprintf(stderr, "seeding %s failed: %s\n", action_name.to_string().c_str(), e.what());
+        std::exit(1);
+      }
+    }
+
+    // `size` members on both communities, `size` open claims with one check each
+    void seed() {
+      push_or_die(community_contract, name{"create"}, founder,
+                  asset(0, community_symbol), founder, std::string("logo"), std::string("BeSpiral"),
+                  std::string("Benchmark community"), asset(1, community_symbol), asset(1, community_symbol));
+      push_or_die(token_contract, name{"create"}, founder,
+                  founder, asset(4000000000000000000, community_symbol), asset(-10000000, community_symbol), std::string("mcc"));
+
+      push_or_die(community_contract, name{"create"}, founder,
+                  asset(0, expiry_symbol), founder, std::string("logo"), std::string("Expiry"),
+                  std::string("Benchmark expiry community"), asset(0, expiry_symbol), asset(0, expiry_symbol));
+      push_or_die(token_contract, name{"create"}, founder,
+                  founder, asset(4000000000000000000, expiry_symbol), asset(0, expiry_symbol), std::string("expiry"));
+
+      for (auto validator : { validator_one, validator_two })
+        push_or_die(community_contract, name{"netlink"}, founder, asset(0, community_symbol), founder, validator);
+
+      for (uint64_t i = 0; i < _size; i++) {
+        _chain.create_account(member(i));
+        push_or_die(community_contract, name{"netlink"}, founder, asset(0, community_symbol), founder, member(i));
+        push_or_die(community_contract, name{"netlink"}, founder, asset(0, expiry_symbol), founder, member(i));
+      }
+
+      push_or_die(community_contract, name{"newobjective"}, founder,
+                  asset(0, community_symbol), std::string("Benchmark objective"), founder);
+      push_or_die(community_contract, name{"upsertaction"}, founder,
+                  uint64_t(0), uint64_t(1), std::string("Benchmark action"),
+                  asset(10, community_symbol), asset(1, community_symbol), uint64_t(0),
+                  uint64_t(0), uint64_t(0), uint64_t(2), std::string("claimable"),
+                  std::string("founder-valone-valtwo"), uint8_t(0), founder);
+
+      for (uint64_t i = 0; i < _size; i++) {
+        push_or_die(community_contract, name{"claimaction"}, member(i), uint64_t(1), member(i));
+        push_or_die(community_contract, name{"verifyclaim"}, validator_one, i + 1, validator_one, uint8_t(1));
+      }
+    }
+
+    void measure(const char* action_name, const std::function<void(uint64_t)>& push) {
+      result total;
+      _chain.reset_counters();
+
+      for (uint64_t i = 0; i < _reps; i++) {
+        auto start = std::chrono::steady_clock::now();
+        try {
+          push(i);
+        } catch (const std::exception& e) {
+          total.error = e.what();
+          break;
+        }
+        total.micros += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+      }
+
+      total.ops = _chain.counters();
+      print(action_name, total);
+    }
+
+    void print(const char* action_name, const result& r) {
+      if (!r.error.empty()) {
+        std::printf("%10llu  %-13s failed: %s\n", (unsigned long long)_size, action_name, r.error.c_str());
+        return;
+      }
+
+      double reps = _reps;
+      std::printf("%10llu  %-13s %10.2f %8.1f %7.1f %8.1f %7.1f %7.1f %8.1f %7.2f\n",
+                  (unsigned long long)_size, action_name, r.micros / reps,
+                  r.ops.finds / reps, r.ops.stores / reps, r.ops.modifies / reps, r.ops.erases / reps,
+                  r.ops.index_writes / reps, r.ops.bytes_written / reps, r.ops.inline_actions / reps);
+    }
+
+    chain _chain;
+    uint64_t _size;
+    uint32_t _reps;
+  };
+
+}
+
+int main(int argc, char** argv) {
+  uint32_t reps = 100;
+  std::vector<uint64_t> sizes;
+
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+      reps = std::strtoul(argv[++i], nullptr, 10);
+    else
+      sizes.push_back(std::strtoull(argv[i], nullptr, 10));
+  }
+
+  if (sizes.empty())
+    sizes = { 1000, 10000, 100000 };
+
+  std::printf("%10s  %-13s %10s %8s %7s %8s %7s %7s %8s %7s\n",
+              "size", "action", "us/call", "finds", "stores", "modifies", "erases", "idx", "bytes", "inline");
+
+  for (auto size : sizes) {
+    if (size == 0 || reps == 0 || size < reps * (votes_per_batch + 1)) {
+      std::fprintf(stderr, "size must be at least %llu times reps (%u)\n", (unsigned long long)votes_per_batch + 1, reps);
+      return 1;
+    }
+    bench(size, reps).run();
+  }
+
+  return 0;
+}
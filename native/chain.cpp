@@ -0,0 +1,643 @@
+#include "chain.hpp"
+
+#include <eosiolib/crypto.h>
+#include <eosiolib/db.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <dlfcn.h>
+#include <istream>
+#include <ostream>
+
+namespace eosio { namespace native {
+
+  namespace {
+    chain* active_chain = nullptr;
+
+    // Unwinds the current action on eosio_exit; the action still counts as successful
+    struct exit_signal {};
+
+    const uint32_t max_inline_depth = 8;
+  }
+
+  chain::chain() {
+    eosio_assert(active_chain == nullptr, "only one native chain can be active at a time");
+    active_chain = this;
+  }
+
+  chain::~chain() {
+    for (auto& contract : _contracts)
+      dlclose(contract.second.first);
+    active_chain = nullptr;
+  }
+
+  chain& chain::active() {
+    if (active_chain == nullptr)
+      throw assertion_failure("no native chain is active");
+    return *active_chain;
+  }
+
+  void chain::create_account(name account) {
+    _accounts.insert(account);
+  }
+
+  bool chain::is_account(name account) const {
+    return _any_account || _accounts.count(account) > 0;
+  }
+
+  void chain::deploy(name account, const std::string& library) {
+    void* handle = dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle == nullptr)
+      throw assertion_failure(std::string("unable to load contract: ") + dlerror());
+
+    auto fn = reinterpret_cast<apply_fn>(dlsym(handle, "apply"));
+    if (fn == nullptr) {
+      dlclose(handle);
+      throw assertion_failure("contract " + library + " has no apply entry point");
+    }
+
+    create_account(account);
+    auto existing = _contracts.find(account);
+    if (existing != _contracts.end())
+      dlclose(existing->second.first);
+    _contracts[account] = { handle, fn };
+  }
+
+  void chain::push_transaction(const std::vector<action>& actions) {
+    _undo.clear();
+    _console.clear();
+    _executed.clear();
+    size_t committed_changes = _changes.size();
+
+    try {
+      for (const auto& act : actions)
+        execute(act, 0);
+    } catch (...) {
+      _contexts.clear();
+      for (auto itr = _undo.rbegin(); itr != _undo.rend(); ++itr)
+        (*itr)();
+      _undo.clear();
+      _changes.resize(committed_changes);
+      throw;
+    }
+
+    _undo.clear();
+  }
+
+  size_t chain::run_deferred() {
+    std::vector<deferred> due;
+    auto split = std::stable_partition(_deferred.begin(), _deferred.end(),
+                                       [&](const deferred& d) { return d.execute_at > _time; });
+    std::move(split, _deferred.end(), std::back_inserter(due));
+    _deferred.erase(split, _deferred.end());
+
+    for (const auto& d : due) {
+      try {
+        push_transaction(d.trx.actions);
+      } catch (const assertion_failure&) {
+        // A failing deferred transaction is dropped, as on chain
+      }
+    }
+    return due.size();
+  }
+
+  void chain::execute(const action& act, uint32_t depth) {
+    if (depth > max_inline_depth)
+      throw assertion_failure("max inline action depth exceeded");
+
+    apply_context ctx{ &act, act.account, {}, {} };
+    _contexts.push_back(&ctx);
+    _executed.push_back(act);
+
+    apply(ctx, act.account);
+    for (size_t i = 0; i < ctx.notified.size(); ++i) {
+      ctx.receiver = ctx.notified[i];
+      apply(ctx, act.account);
+    }
+
+    _contexts.pop_back();
+
+    for (const auto& inline_act : ctx.inline_actions)
+      execute(inline_act, depth + 1);
+  }
+
+  void chain::apply(apply_context& ctx, name code) {
+    auto contract = _contracts.find(ctx.receiver);
+    if (contract == _contracts.end())
+      return;
+
+    try {
+      contract->second.second(ctx.receiver.value, code.value, ctx.act->name.value);
+    } catch (const exit_signal&) {
+    }
+  }
+
+  chain::apply_context& chain::context() {
+    if (_contexts.empty())
+      throw assertion_failure("no action is being executed");
+    return *_contexts.back();
+  }
+
+  void chain::record_change(uint64_t scope, uint64_t table, uint64_t primary) {
+    if (_track_changes)
+      _changes.push_back({ context().receiver.value, scope, table, primary });
+  }
+
+  void chain::schedule(deferred&& trx) {
+    _deferred.push_back(std::move(trx));
+  }
+
+  bool chain::cancel(const uint128_t& sender_id) {
+    auto before = _deferred.size();
+    _deferred.erase(std::remove_if(_deferred.begin(), _deferred.end(),
+                                   [&](const deferred& d) { return d.sender_id == sender_id; }),
+                    _deferred.end());
+    return before != _deferred.size();
+  }
+
+  const std::vector<char>* chain::get_row(name code, uint64_t scope, name table, uint64_t primary) const {
+    const auto* t = find_table(code.value, scope, table.value);
+    if (t == nullptr)
+      return nullptr;
+    auto itr = t->find(primary);
+    return itr == t->end() ? nullptr : &itr->second.data;
+  }
+
+  size_t chain::row_count(name code, name table) const {
+    size_t count = 0;
+    for (auto itr = _tables.lower_bound(table_key{code.value, 0, 0});
+         itr != _tables.end() && itr->first.code == code.value; ++itr) {
+      if (itr->first.table == table.value)
+        count += itr->second.size();
+    }
+    return count;
+  }
+
+  void chain::restore_snapshot(snapshot state) {
+    _tables = std::move(state.tables);
+    _indexes = std::move(state.indexes);
+  }
+
+  namespace {
+    const char snapshot_magic[8] = { 'B', 'E', 'S', 'S', 'N', 'A', 'P', '1' };
+
+    template<typename T>
+    void write_raw(std::ostream& out, const T& value) {
+      out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    T read_raw(std::istream& in) {
+      T value;
+      if (!in.read(reinterpret_cast<char*>(&value), sizeof(T)))
+        throw assertion_failure("truncated snapshot");
+      return value;
+    }
+
+    void write_bytes(std::ostream& out, const char* data, uint32_t size) {
+      write_raw(out, size);
+      out.write(data, size);
+    }
+
+    template<typename Container>
+    Container read_bytes(std::istream& in) {
+      Container data(read_raw<uint32_t>(in), 0);
+      if (!data.empty() && !in.read(&data[0], data.size()))
+        throw assertion_failure("truncated snapshot");
+      return data;
+    }
+  }
+
+  /*
+    Layout: magic, then the tables as (code, scope, table, row count) followed by their
+    (primary, payer, data) rows, then the indexes as (code, scope, table, index, entry count)
+    followed by their (key, primary) entries. Integers are little-endian.
+  */
+  void chain::snapshot::save(std::ostream& out) const {
+    out.write(snapshot_magic, sizeof(snapshot_magic));
+
+    write_raw<uint64_t>(out, tables.size());
+    for (const auto& t : tables) {
+      write_raw(out, t.first);
+      write_raw<uint64_t>(out, t.second.size());
+      for (const auto& r : t.second) {
+        write_raw(out, r.first);
+        write_raw(out, r.second.payer);
+        write_bytes(out, r.second.data.data(), r.second.data.size());
+      }
+    }
+
+    write_raw<uint64_t>(out, indexes.size());
+    for (const auto& idx : indexes) {
+      write_raw(out, idx.first);
+      write_raw<uint64_t>(out, idx.second.size());
+      for (const auto& entry : idx.second) {
+        write_bytes(out, entry.first.data(), entry.first.size());
+        write_raw(out, entry.second);
+      }
+    }
+  }
+
+  chain::snapshot chain::snapshot::load(std::istream& in) {
+    char magic[sizeof(snapshot_magic)];
+    if (!in.read(magic, sizeof(magic)) || memcmp(magic, snapshot_magic, sizeof(magic)) != 0)
+      throw assertion_failure("not a native chain snapshot");
+
+    snapshot state;
+    for (auto tables = read_raw<uint64_t>(in); tables > 0; tables--) {
+      auto& t = state.tables[read_raw<table_key>(in)];
+      for (auto count = read_raw<uint64_t>(in); count > 0; count--) {
+        auto primary = read_raw<uint64_t>(in);
+        auto payer = read_raw<uint64_t>(in);
+        t.emplace(primary, row{ read_bytes<std::vector<char>>(in), payer });
+      }
+    }
+
+    for (auto indexes = read_raw<uint64_t>(in); indexes > 0; indexes--) {
+      auto& idx = state.indexes[read_raw<index_key>(in)];
+      for (auto count = read_raw<uint64_t>(in); count > 0; count--) {
+        auto key = read_bytes<std::string>(in);
+        idx.emplace(std::move(key), read_raw<uint64_t>(in));
+      }
+    }
+
+    return state;
+  }
+
+  const chain::rows* chain::find_table(uint64_t code, uint64_t scope, uint64_t table) const {
+    auto itr = _tables.find(table_key{code, scope, table});
+    return itr == _tables.end() ? nullptr : &itr->second;
+  }
+
+  chain::rows& chain::table(uint64_t scope, uint64_t table) {
+    return _tables[table_key{context().receiver.value, scope, table}];
+  }
+
+  const chain::entries* chain::find_index(uint64_t code, uint64_t scope, uint64_t table, uint64_t index) const {
+    auto itr = _indexes.find(index_key{code, scope, table, index});
+    return itr == _indexes.end() ? nullptr : &itr->second;
+  }
+
+  chain::entries& chain::index(uint64_t scope, uint64_t table, uint64_t index) {
+    return _indexes[index_key{context().receiver.value, scope, table, index}];
+  }
+
+  // ---------------------------------------------------------------------------------------
+  // Database
+
+  const std::vector<char>* db_get(uint64_t code, uint64_t scope, uint64_t table, uint64_t primary) {
+    auto& c = chain::active();
+    c.counters().finds++;
+    const auto* t = c.find_table(code, scope, table);
+    if (t == nullptr)
+      return nullptr;
+    auto itr = t->find(primary);
+    return itr == t->end() ? nullptr : &itr->second.data;
+  }
+
+  bool db_lower_bound(uint64_t code, uint64_t scope, uint64_t table, uint64_t primary, uint64_t& found) {
+    auto& c = chain::active();
+    c.counters().finds++;
+    const auto* t = c.find_table(code, scope, table);
+    if (t == nullptr)
+      return false;
+    auto itr = t->lower_bound(primary);
+    if (itr == t->end())
+      return false;
+    found = itr->first;
+    return true;
+  }
+
+  bool db_upper_bound(uint64_t code, uint64_t scope, uint64_t table, uint64_t primary, uint64_t& found) {
+    auto& c = chain::active();
+    c.counters().finds++;
+    const auto* t = c.find_table(code, scope, table);
+    if (t == nullptr)
+      return false;
+    auto itr = t->upper_bound(primary);
+    if (itr == t->end())
+      return false;
+    found = itr->first;
+    return true;
+  }
+
+  bool db_previous(uint64_t code, uint64_t scope, uint64_t table, uint64_t primary, uint64_t& found) {
+    auto& c = chain::active();
+    c.counters().finds++;
+    const auto* t = c.find_table(code, scope, table);
+    if (t == nullptr)
+      return false;
+    auto itr = t->lower_bound(primary);
+    if (itr == t->begin())
+      return false;
+    found = (--itr)->first;
+    return true;
+  }
+
+  bool db_last(uint64_t code, uint64_t scope, uint64_t table, uint64_t& found) {
+    auto& c = chain::active();
+    c.counters().finds++;
+    const auto* t = c.find_table(code, scope, table);
+    if (t == nullptr || t->empty())
+      return false;
+    found = t->rbegin()->first;
+    return true;
+  }
+
+  void db_store(uint64_t scope, uint64_t table, uint64_t payer, uint64_t primary, const std::vector<char>& data) {
+    auto& c = chain::active();
+    auto& t = c.table(scope, table);
+    eosio_assert(t.count(primary) == 0, "could not insert object, most likely a uniqueness constraint was violated");
+    c.counters().stores++;
+    c.counters().bytes_written += data.size();
+    t.emplace(primary, chain::row{ data, payer });
+    c.record_undo([&t, primary]() { t.erase(primary); });
+    c.record_change(scope, table, primary);
+  }
+
+  void db_update(uint64_t scope, uint64_t table, uint64_t payer, uint64_t primary, const std::vector<char>& data) {
+    auto& c = chain::active();
+    auto& t = c.table(scope, table);
+    auto itr = t.find(primary);
+    eosio_assert(itr != t.end(), "unable to find key");
+    c.counters().modifies++;
+    c.counters().bytes_written += data.size();
+    auto old = itr->second;
+    itr->second.data = data;
+    if (payer != 0)
+      itr->second.payer = payer;
+    c.record_undo([&t, primary, old]() { t[primary] = old; });
+    c.record_change(scope, table, primary);
+  }
+
+  void db_remove(uint64_t scope, uint64_t table, uint64_t primary) {
+    auto& c = chain::active();
+    auto& t = c.table(scope, table);
+    auto itr = t.find(primary);
+    eosio_assert(itr != t.end(), "unable to find key");
+    c.counters().erases++;
+    auto old = itr->second;
+    t.erase(itr);
+    c.record_undo([&t, primary, old]() { t.emplace(primary, old); });
+    c.record_change(scope, table, primary);
+  }
+
+  namespace {
+    bool to_entry(const chain::entries* idx, chain::entries::const_iterator itr, index_entry& found) {
+      if (itr == idx->end())
+        return false;
+      found.key = itr->first;
+      found.primary = itr->second;
+      return true;
+    }
+  }
+
+  bool idx_lower_bound(uint64_t code, uint64_t scope, uint64_t table, uint64_t index,
+                       const std::string& key, uint64_t primary, index_entry& found) {
+    auto& c = chain::active();
+    c.counters().finds++;
+    const auto* idx = c.find_index(code, scope, table, index);
+    if (idx == nullptr)
+      return false;
+    return to_entry(idx, idx->lower_bound({ key, primary }), found);
+  }
+
+  bool idx_upper_bound(uint64_t code, uint64_t scope, uint64_t table, uint64_t index,
+                       const std::string& key, index_entry& found) {
+    auto& c = chain::active();
+    c.counters().finds++;
+    const auto* idx = c.find_index(code, scope, table, index);
+    if (idx == nullptr)
+      return false;
+    return to_entry(idx, idx->upper_bound({ key, std::numeric_limits<uint64_t>::max() }), found);
+  }
+
+  bool idx_next(uint64_t code, uint64_t scope, uint64_t table, uint64_t index,
+                const index_entry& from, index_entry& found) {
+    auto& c = chain::active();
+    c.counters().finds++;
+    const auto* idx = c.find_index(code, scope, table, index);
+    if (idx == nullptr)
+      return false;
+    return to_entry(idx, idx->upper_bound({ from.key, from.primary }), found);
+  }
+
+  bool idx_previous(uint64_t code, uint64_t scope, uint64_t table, uint64_t index,
+                    const index_entry& from, index_entry& found) {
+    auto& c = chain::active();
+    c.counters().finds++;
+    const auto* idx = c.find_index(code, scope, table, index);
+    if (idx == nullptr)
+      return false;
+    auto itr = idx->lower_bound({ from.key, from.primary });
+    if (itr == idx->begin())
+      return false;
+    return to_entry(idx, --itr, found);
+  }
+
+  bool idx_last(uint64_t code, uint64_t scope, uint64_t table, uint64_t index, index_entry& found) {
+    auto& c = chain::active();
+    c.counters().finds++;
+    const auto* idx = c.find_index(code, scope, table, index);
+    if (idx == nullptr || idx->empty())
+      return false;
+    return to_entry(idx, std::prev(idx->end()), found);
+  }
+
+  void idx_store(uint64_t scope, uint64_t table, uint64_t index, const std::string& key, uint64_t primary) {
+    auto& c = chain::active();
+    auto& idx = c.index(scope, table, index);
+    c.counters().index_writes++;
+    idx.emplace(key, primary);
+    c.record_undo([&idx, key, primary]() { idx.erase({ key, primary }); });
+  }
+
+  void idx_remove(uint64_t scope, uint64_t table, uint64_t index, const std::string& key, uint64_t primary) {
+    auto& c = chain::active();
+    auto& idx = c.index(scope, table, index);
+    c.counters().index_writes++;
+    idx.erase({ key, primary });
+    c.record_undo([&idx, key, primary]() { idx.emplace(key, primary); });
+  }
+
+}} // namespace eosio::native
+
+// -----------------------------------------------------------------------------------------
+// Authorization and notifications
+
+namespace eosio {
+
+  using native::chain;
+
+  void require_auth(name n) {
+    eosio_assert(has_auth(n), ("missing authority of " + n.to_string()).c_str());
+  }
+
+  void require_auth(const permission_level& level) {
+    const auto& auths = chain::active().context().act->authorization;
+    bool found = std::find(auths.begin(), auths.end(), level) != auths.end();
+    eosio_assert(found, ("missing authority of " + level.actor.to_string()).c_str());
+  }
+
+  bool has_auth(name n) {
+    const auto& auths = chain::active().context().act->authorization;
+    return std::any_of(auths.begin(), auths.end(), [&](const permission_level& p) { return p.actor == n; });
+  }
+
+  bool is_account(name n) {
+    return chain::active().is_account(n);
+  }
+
+  void require_recipient(name notify_account) {
+    auto& ctx = chain::active().context();
+    if (notify_account == ctx.act->account)
+      return;
+    if (std::find(ctx.notified.begin(), ctx.notified.end(), notify_account) == ctx.notified.end())
+      ctx.notified.push_back(notify_account);
+  }
+
+} // namespace eosio
+
+// -----------------------------------------------------------------------------------------
+// Intrinsics
+
+using eosio::native::chain;
+
+extern "C" {
+
+  void eosio_assert(uint32_t test, const char* msg) {
+    if (!test)
+      throw eosio::native::assertion_failure(std::string("assertion failure with message: ") + msg);
+  }
+
+  void eosio_assert_message(uint32_t test, const char* msg, uint32_t msg_len) {
+    if (!test)
+      throw eosio::native::assertion_failure("assertion failure with message: " + std::string(msg, msg_len));
+  }
+
+  void eosio_assert_code(uint32_t test, uint64_t code) {
+    if (!test)
+      throw eosio::native::assertion_failure("assertion failure with error code: " + std::to_string(code));
+  }
+
+  void eosio_exit(int32_t) {
+    throw eosio::native::exit_signal{};
+  }
+
+  uint64_t current_time() {
+    return uint64_t(chain::active().time()) * 1000000;
+  }
+
+  uint32_t read_action_data(void* msg, uint32_t len) {
+    const auto& data = chain::active().context().act->data;
+    uint32_t size = std::min<uint32_t>(len, data.size());
+    if (size > 0)
+      memcpy(msg, data.data(), size);
+    return size;
+  }
+
+  uint32_t action_data_size() {
+    return chain::active().context().act->data.size();
+  }
+
+  uint64_t current_receiver() {
+    return chain::active().context().receiver.value;
+  }
+
+  void send_inline(char* serialized_action, size_t size) {
+    auto& c = chain::active();
+    c.counters().inline_actions++;
+    c.context().inline_actions.push_back(eosio::unpack<eosio::action>(serialized_action, size));
+  }
+
+  void send_deferred(const uint128_t& sender_id, capi_name payer, const char* serialized_transaction,
+                     size_t size, uint32_t replace_existing) {
+    auto& c = chain::active();
+    auto trx = eosio::unpack<eosio::transaction>(serialized_transaction, size);
+    if (replace_existing)
+      c.cancel(sender_id);
+    c.schedule(chain::deferred{ sender_id, eosio::name(payer), c.time() + trx.delay_sec.value, trx });
+  }
+
+  int cancel_deferred(const uint128_t& sender_id) {
+    return chain::active().cancel(sender_id) ? 1 : 0;
+  }
+
+  void sha256(const char* data, uint32_t length, capi_checksum256* hash) {
+    static const uint32_t k[64] = {
+      0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+      0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+      0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+      0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+      0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+      0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+      0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+      0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2 };
+
+    uint32_t h[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+
+    std::vector<uint8_t> msg(data, data + length);
+    uint64_t bits = uint64_t(length) * 8;
+    msg.push_back(0x80);
+    while (msg.size() % 64 != 56)
+      msg.push_back(0);
+    for (int i = 7; i >= 0; --i)
+      msg.push_back(uint8_t(bits >> (i * 8)));
+
+    auto rotr = [](uint32_t x, int n) { return (x >> n) | (x << (32 - n)); };
+
+    for (size_t chunk = 0; chunk < msg.size(); chunk += 64) {
+      uint32_t w[64];
+      for (int i = 0; i < 16; ++i)
+        w[i] = uint32_t(msg[chunk + i * 4]) << 24 | uint32_t(msg[chunk + i * 4 + 1]) << 16 |
+               uint32_t(msg[chunk + i * 4 + 2]) << 8 | uint32_t(msg[chunk + i * 4 + 3]);
+      for (int i = 16; i < 64; ++i) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+      }
+
+      uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+      for (int i = 0; i < 64; ++i) {
+        uint32_t t1 = hh + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+        uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        hh = g; g = f; f = e; e = d + t1; d = c; c = b; b = a; a = t1 + t2;
+      }
+      h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e; h[5] += f; h[6] += g; h[7] += hh;
+    }
+
+    for (int i = 0; i < 8; ++i)
+      for (int j = 0; j < 4; ++j)
+        hash->hash[i * 4 + j] = uint8_t(h[i] >> (24 - j * 8));
+  }
+
+  void assert_sha256(const char* data, uint32_t length, const capi_checksum256* hash) {
+    capi_checksum256 result;
+    sha256(data, length, &result);
+    eosio_assert(memcmp(result.hash, hash->hash, 32) == 0, "hash mismatch");
+  }
+
+  void prints(const char* cstr) {
+    chain::active().print(cstr, strlen(cstr));
+  }
+
+  void prints_l(const char* cstr, uint32_t len) {
+    chain::active().print(cstr, len);
+  }
+
+  void printi(int64_t value) {
+    auto s = std::to_string(value);
+    chain::active().print(s.data(), s.size());
+  }
+
+  void printui(uint64_t value) {
+    auto s = std::to_string(value);
+    chain::active().print(s.data(), s.size());
+  }
+
+  void printn(uint64_t value) {
+    auto s = eosio::name(value).to_string();
+    chain::active().print(s.data(), s.size());
+  }
+
+}
@@ -0,0 +1,200 @@
+#pragma once
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/transaction.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace eosio { namespace native {
+
+  /// Raised by eosio_assert; the failing transaction is rolled back before it reaches the caller
+  struct assertion_failure : std::runtime_error {
+    using std::runtime_error::runtime_error;
+  };
+
+  /**
+     In-memory chain used to run the contracts natively.
+
+     Holds accounts, a clock, the contract tables and the deployed contracts, which are loaded
+     from shared objects built out of the unmodified contract sources. Every pushed transaction
+     runs its actions, their notifications and inline actions in order, and is rolled back as a
+     whole when any of them fails an assertion.
+
+     Authorization is checked against the declared actors only: permissions, `eosio.code` and
+     resource limits are not modelled.
+  */
+  class chain {
+  public:
+    chain();
+    ~chain();
+
+    chain(const chain&) = delete;
+    chain& operator=(const chain&) = delete;
+
+    void create_account(name account);
+    bool is_account(name account) const;
+
+    /// Treat every name as an existing account, for replaying traces without their account creations
+    void accept_any_account(bool accept) { _any_account = accept; }
+
+    /// Loads a contract built by the native Makefile and deploys it to `account`
+    void deploy(name account, const std::string& library);
+
+    void set_time(uint32_t seconds) { _time = seconds; }
+    void advance_time(uint32_t seconds) { _time += seconds; }
+    uint32_t time() const { return _time; }
+
+    /// Runs the given actions as a single transaction, throwing assertion_failure when it aborts
+    void push_transaction(const std::vector<action>& actions);
+
+    template<typename... Args>
+    void push(name account, name action_name, name actor, Args&&... args) {
+      push_transaction({ action(permission_level{actor, name{"active"}}, account, action_name,
+                                std::make_tuple(std::forward<Args>(args)...)) });
+    }
+
+    /// Executes deferred transactions whose delay has elapsed, returns how many ran
+    size_t run_deferred();
+
+    /// Raw row access for inspecting state from the host
+    const std::vector<char>* get_row(name code, uint64_t scope, name table, uint64_t primary) const;
+
+    template<typename T>
+    T get_row_as(name code, uint64_t scope, name table, uint64_t primary) const {
+      const auto* data = get_row(code, scope, table, primary);
+      if (data == nullptr)
+        throw assertion_failure("unable to find row in " + table.to_string());
+      return unpack<T>(*data);
+    }
+
+    /// Number of rows of a table, across all its scopes
+    size_t row_count(name code, name table) const;
+
+    /// Console output printed by the last transaction
+    const std::string& console() const { return _console; }
+
+    /// Actions run by the last transaction in execution order, inline actions included
+    const std::vector<action>& executed() const { return _executed; }
+
+    /// A row stored, modified or erased by a committed transaction
+    struct row_change {
+      uint64_t code, scope, table, primary;
+    };
+
+    /// Record the rows committed transactions change, for hosts that keep state derived from the tables
+    void track_changes(bool track) { _track_changes = track; _changes.clear(); }
+
+    /// Rows changed since the last call, in order. The current row, if any, is read with get_row
+    std::vector<row_change> take_changes() {
+      std::vector<row_change> changes;
+      changes.swap(_changes);
+      return changes;
+    }
+
+    /// Work done by the contracts since the last reset_counters, rolled back transactions included
+    struct op_counters {
+      uint64_t finds = 0;          // Primary and secondary lookups, iteration steps included
+      uint64_t stores = 0;
+      uint64_t modifies = 0;
+      uint64_t erases = 0;
+      uint64_t index_writes = 0;   // Secondary index entries added or removed
+      uint64_t bytes_written = 0;  // Serialized row bytes stored or modified
+      uint64_t inline_actions = 0;
+    };
+
+    const op_counters& counters() const { return _counters; }
+    op_counters& counters() { return _counters; }
+    void reset_counters() { _counters = {}; }
+
+    static chain& active();
+
+    // Entry points used by the intrinsics
+    struct table_key {
+      uint64_t code, scope, table;
+      bool operator<(const table_key& o) const { return std::tie(code, scope, table) < std::tie(o.code, o.scope, o.table); }
+    };
+
+    struct index_key {
+      uint64_t code, scope, table, index;
+      bool operator<(const index_key& o) const {
+        return std::tie(code, scope, table, index) < std::tie(o.code, o.scope, o.table, o.index);
+      }
+    };
+
+    struct row {
+      std::vector<char> data;
+      uint64_t payer;
+    };
+
+    typedef std::map<uint64_t, row> rows;
+    typedef std::set<std::pair<std::string, uint64_t>> entries;
+
+    struct apply_context {
+      const action* act;
+      name receiver;
+      std::vector<name> notified;
+      std::vector<action> inline_actions;
+    };
+
+    struct deferred {
+      uint128_t sender_id;
+      name payer;
+      uint32_t execute_at;
+      transaction trx;
+    };
+
+    const rows* find_table(uint64_t code, uint64_t scope, uint64_t table) const;
+    rows& table(uint64_t scope, uint64_t table);
+    const entries* find_index(uint64_t code, uint64_t scope, uint64_t table, uint64_t index) const;
+    entries& index(uint64_t scope, uint64_t table, uint64_t index);
+
+    /// Every table row and secondary index entry, used to save, restore and compare states
+    struct snapshot {
+      std::map<table_key, rows> tables;
+      std::map<index_key, entries> indexes;
+
+      void save(std::ostream& out) const;
+      static snapshot load(std::istream& in);
+    };
+
+    snapshot take_snapshot() const { return { _tables, _indexes }; }
+    void restore_snapshot(snapshot state);
+
+    apply_context& context();
+    void record_undo(std::function<void()> undo) { _undo.push_back(std::move(undo)); }
+    void record_change(uint64_t scope, uint64_t table, uint64_t primary);
+    void print(const char* data, size_t size) { _console.append(data, size); }
+    void schedule(deferred&& trx);
+    bool cancel(const uint128_t& sender_id);
+
+  private:
+    typedef void (*apply_fn)(uint64_t, uint64_t, uint64_t);
+
+    void execute(const action& act, uint32_t depth);
+    void apply(apply_context& ctx, name code);
+
+    std::set<name> _accounts;
+    bool _any_account = false;
+    std::map<name, std::pair<void*, apply_fn>> _contracts;
+    std::map<table_key, rows> _tables;
+    std::map<index_key, entries> _indexes;
+    std::vector<deferred> _deferred;
+
+    std::vector<apply_context*> _contexts;
+    std::vector<std::function<void()>> _undo;
+    std::string _console;
+    std::vector<action> _executed;
+    bool _track_changes = false;
+    std::vector<row_change> _changes;
+    op_counters _counters;
+    uint32_t _time = 0;
+  };
+
+}} // namespace eosio::native
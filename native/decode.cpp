@@ -0,0 +1,314 @@
+#include "abi.hpp"
+#include "records.hpp"
+
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/asset.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+/**
+   Decodes contract table rows offline into one file per column, driven by the contracts' ABIs.
+
+   Inputs are memory mapped and decoded in place, row by row. They are either snapshots saved by
+   the native chain (`replay --save`) or JSON dumps of `get_table_rows` pages fetched with
+   `"json": false`, one page per line or in an array, each page carrying its `code`, `table` and
+   `scope` next to the `rows`. Rows are hex strings, or objects with the hex in `data`.
+
+   Each table gets a folder `<out>/<code>.<table>` holding `scope.txt` and a `<field>.txt` per
+   top level field, with one value per line so the files line up row by row. Scopes, names,
+   symbols and assets are written in their text form, nested structs and arrays as JSON, and
+   missing binary extensions as empty lines. Rows that don't decode are counted and left out of
+   every column.
+
+   Usage: decode [--abi code=file] [--out dir] [--tables t1,t2,... | --all-tables] input...
+*/
+
+using eosio::native::abi_def;
+using eosio::native::json;
+using eosio::native::json_reader;
+using eosio::native::row_decoder;
+using eosio::native::type_node;
+using eosio::native::parse_hex;
+using eosio::native::load_abi;
+using eosio::native::read_file;
+
+namespace {
+
+  // Buffered writer of one column file
+  class column {
+  public:
+    explicit column(const std::string& path) : _file(std::fopen(path.c_str(), "wb")) {
+      if (!_file)
+        throw std::runtime_error("unable to create " + path);
+      std::setvbuf(_file, nullptr, _IOFBF, 1 << 16);
+    }
+
+    ~column() { std::fclose(_file); }
+
+    void write(const std::string& value) {
+      std::fwrite(value.data(), 1, value.size(), _file);
+      std::fputc('\n', _file);
+    }
+
+  private:
+    std::FILE* _file;
+  };
+
+  struct table_output {
+    const type_node* type = nullptr;
+    std::unique_ptr<column> scope;
+    std::vector<std::unique_ptr<column>> fields;
+    std::vector<std::string> values;
+    uint64_t rows = 0;
+    uint64_t failed = 0;
+  };
+
+  class decoder {
+  public:
+    decoder(std::map<std::string, abi_def> abis, std::string out, std::set<std::string> tables)
+      : _abis(std::move(abis)), _out(std::move(out)), _tables(std::move(tables)) {
+      mkdir(_out.c_str(), 0755);
+    }
+
+    void row(const std::string& code, const std::string& table, const std::string& scope, const char* data, size_t size) {
+      table_output* output = find_output(code, table);
+      if (output == nullptr)
+        return;
+
+      try {
+        row_decoder reader(data, data + size);
+        const auto& fields = output->type->fields;
+        for (size_t i = 0; i < fields.size(); i++) {
+          output->values[i].clear();
+          reader.value(fields[i].second, output->values[i], false);
+        }
+      } catch (const std::exception&) {
+        output->failed++;
+        return;
+      }
+
+      output->scope->write(scope);
+      for (size_t i = 0; i < output->fields.size(); i++)
+        output->fields[i]->write(output->values[i]);
+      output->rows++;
+      _bytes += size;
+    }
+
+    void report(double seconds) const {
+      uint64_t rows = 0;
+      std::printf("%-28s %12s %10s\n", "table", "rows", "failed");
+      for (const auto& o : _outputs) {
+        if (!o.second) continue;
+        rows += o.second->rows;
+        std::printf("%-28s %12llu %10llu\n", (o.first.first + "." + o.first.second).c_str(),
+                    (unsigned long long)o.second->rows, (unsigned long long)o.second->failed);
+      }
+      std::printf("\ndecoded %llu rows, %.1f MB in %.3f s, %.0f rows/s\n", (unsigned long long)rows,
+                  _bytes / 1e6, seconds, rows / std::max(seconds, 1e-9));
+    }
+
+  private:
+    table_output* find_output(const std::string& code, const std::string& table) {
+      auto key = std::make_pair(code, table);
+      auto found = _outputs.find(key);
+      if (found != _outputs.end())
+        return found->second.get();
+
+      auto& output = _outputs[key];
+      auto abi = _abis.find(code);
+      if (abi == _abis.end() || !abi->second.tables.count(table) || (!_tables.empty() && !_tables.count(table)))
+        return nullptr;
+
+      output.reset(new table_output);
+      output->type = abi->second.compile(abi->second.tables.at(table));
+      if (output->type->kind != type_node::structure)
+        throw std::runtime_error("row type of " + table + " is not a struct");
+
+      std::string folder = _out + "/" + code + "." + table;
+      mkdir(folder.c_str(), 0755);
+      output->scope.reset(new column(folder + "/scope.txt"));
+      for (const auto& field : output->type->fields)
+        output->fields.emplace_back(new column(folder + "/" + field.first + ".txt"));
+      output->values.resize(output->type->fields.size());
+      return output.get();
+    }
+
+    std::map<std::string, abi_def> _abis;
+    std::string _out;
+    std::set<std::string> _tables;
+    std::map<std::pair<std::string, std::string>, std::unique_ptr<table_output>> _outputs;
+    uint64_t _bytes = 0;
+  };
+
+  class mapped_file {
+  public:
+    explicit mapped_file(const std::string& path) {
+      int fd = open(path.c_str(), O_RDONLY);
+      struct stat st;
+      if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) close(fd);
+        throw std::runtime_error("unable to open " + path);
+      }
+
+      _size = st.st_size;
+      if (_size > 0) {
+        _data = static_cast<const char*>(mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0));
+        if (_data == MAP_FAILED) {
+          close(fd);
+          throw std::runtime_error("unable to map " + path);
+        }
+        madvise(const_cast<char*>(_data), _size, MADV_SEQUENTIAL);
+      }
+      close(fd);
+    }
+
+    ~mapped_file() {
+      if (_size > 0) munmap(const_cast<char*>(_data), _size);
+    }
+
+    const char* begin() const { return _data; }
+    const char* end() const { return _data + _size; }
+    size_t size() const { return _size; }
+
+  private:
+    const char* _data = nullptr;
+    size_t _size = 0;
+  };
+
+  const char snapshot_magic[8] = { 'B', 'E', 'S', 'S', 'N', 'A', 'P', '1' };
+
+  // Walks the tables of a native chain snapshot, see chain::snapshot::save for the layout
+  void decode_snapshot(const mapped_file& file, decoder& out) {
+    const char* pos = file.begin() + sizeof(snapshot_magic);
+    auto take = [&](size_t size) {
+      if (size_t(file.end() - pos) < size)
+        throw std::runtime_error("truncated snapshot");
+      const char* begin = pos;
+      pos += size;
+      return begin;
+    };
+    auto read_u64 = [&] { uint64_t v; std::memcpy(&v, take(8), 8); return v; };
+
+    for (uint64_t tables = read_u64(); tables > 0; tables--) {
+      std::string code = eosio::name{read_u64()}.to_string();
+      std::string scope = eosio::name{read_u64()}.to_string();
+      std::string table = eosio::name{read_u64()}.to_string();
+
+      for (uint64_t rows = read_u64(); rows > 0; rows--) {
+        take(16); // Primary key and payer
+        uint32_t size;
+        std::memcpy(&size, take(4), 4);
+        out.row(code, table, scope, take(size), size);
+      }
+    }
+  }
+
+  void decode_page(const json& page, decoder& out) {
+    const json* code = page.find("code");
+    const json* table = page.find("table");
+    const json* rows = page.find("rows");
+    if (!code || !table || !rows)
+      throw std::runtime_error("table page without code, table or rows");
+
+    const json* scope = page.find("scope");
+    std::string scope_text = scope ? scope->as_string() : code->as_string();
+
+    for (const auto& r : rows->items) {
+      const json* hex = r.kind == json::object ? r.find("data") : &r;
+      if (!hex || hex->kind != json::string)
+        throw std::runtime_error("rows must be hex, fetch them with \"json\": false");
+      auto data = parse_hex(hex->as_string());
+      out.row(code->as_string(), table->as_string(), scope_text, data.data(), data.size());
+    }
+  }
+
+  void decode_json(const mapped_file& file, decoder& out) {
+    json_reader reader(file.begin(), file.end());
+    if (reader.enter_array()) {
+      while (reader.more_in_array())
+        decode_page(reader.next(), out);
+      return;
+    }
+    while (reader.more())
+      decode_page(reader.next(), out);
+  }
+
+}
+
+int main(int argc, char** argv) {
+  std::map<std::string, std::string> abi_paths = {
+    { "bes.cmm", "../bespiral.community/bespiral.community.abi" },
+    { "bes.token", "../bespiral.token/bespiral.token.abi" }
+  };
+  std::string out = "columns";
+  std::set<std::string> tables = { "community", "network", "claim", "check", "sale", "accounts", "stat" };
+  std::vector<std::string> inputs;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "--abi" && has_value) {
+      std::string value = argv[++i];
+      auto eq = value.find('=');
+      if (eq == std::string::npos) {
+        std::fprintf(stderr, "--abi takes code=file\n");
+        return 1;
+      }
+      abi_paths[value.substr(0, eq)] = value.substr(eq + 1);
+    }
+    else if (arg == "--out" && has_value) out = argv[++i];
+    else if (arg == "--tables" && has_value) {
+      tables.clear();
+      std::string list = argv[++i];
+      for (size_t start = 0, end; start <= list.size(); start = end + 1) {
+        end = std::min(list.find(',', start), list.size());
+        if (end > start) tables.insert(list.substr(start, end - start));
+      }
+    }
+    else if (arg == "--all-tables") tables.clear();
+    else if (arg.compare(0, 2, "--") == 0) {
+      std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+      return 1;
+    }
+    else inputs.push_back(arg);
+  }
+
+  if (inputs.empty()) {
+    std::fprintf(stderr, "usage: decode [--abi code=file] [--out dir] [--tables t1,t2,... | --all-tables] input...\n");
+    return 1;
+  }
+
+  try {
+    std::map<std::string, abi_def> abis;
+    for (const auto& a : abi_paths)
+      abis.emplace(a.first, load_abi(read_file(a.second)));
+
+    decoder decode(std::move(abis), out, tables);
+
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& path : inputs) {
+      mapped_file file(path);
+      if (file.size() >= sizeof(snapshot_magic) && std::memcmp(file.begin(), snapshot_magic, sizeof(snapshot_magic)) == 0)
+        decode_snapshot(file, decode);
+      else
+        decode_json(file, decode);
+    }
+    decode.report(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    return 0;
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "decode failed: %s\n", e.what());
+    return 1;
+  }
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include "types.h"
+
+extern "C" {
+  uint32_t read_action_data(void* msg, uint32_t len);
+  uint32_t action_data_size();
+  uint64_t current_receiver();
+  void send_inline(char* serialized_action, size_t size);
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include "action.h"
+#include "system.h"
+#include "datastream.hpp"
+#include "name.hpp"
+#include "serialize.hpp"
+
+#include <cstdlib>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace eosio {
+
+  /// Packed representation of a permission level (Authorization)
+  struct permission_level {
+    permission_level(name a, name p) : actor(a), permission(p) {}
+    permission_level() {}
+
+    name actor;
+    name permission;
+
+    friend constexpr bool operator==(const permission_level& a, const permission_level& b) {
+      return a.actor == b.actor && a.permission == b.permission;
+    }
+
+    EOSLIB_SERIALIZE(permission_level, (actor)(permission))
+  };
+
+  /// Packed representation of an action along with meta-data about the authorization levels
+  struct action {
+    eosio::name account;
+    eosio::name name;
+    std::vector<permission_level> authorization;
+    std::vector<char> data;
+
+    action() = default;
+
+    template<typename T>
+    action(const permission_level& auth, struct name a, struct name n, T&& value)
+      : account(a), name(n), authorization(1, auth), data(pack(std::forward<T>(value))) {}
+
+    template<typename T>
+    action(std::vector<permission_level> auths, struct name a, struct name n, T&& value)
+      : account(a), name(n), authorization(std::move(auths)), data(pack(std::forward<T>(value))) {}
+
+    EOSLIB_SERIALIZE(action, (account)(name)(authorization)(data))
+
+    /// Queues this action to run after the current one completes
+    void send() const {
+      auto serialize = pack(*this);
+      ::send_inline(serialize.data(), serialize.size());
+    }
+
+    template<typename T>
+    T data_as() {
+      return unpack<T>(&data[0], data.size());
+    }
+  };
+
+  /// Verifies the specified account exists in the set of provided auths; aborts otherwise
+  void require_auth(name n);
+  void require_auth(const permission_level& level);
+
+  /// Checks whether the specified account exists in the set of provided auths
+  bool has_auth(name n);
+
+  /// Checks whether the specified account exists
+  bool is_account(name n);
+
+  /// Adds the specified account to the set of accounts to be notified
+  void require_recipient(name notify_account);
+
+  template<typename... accounts>
+  void require_recipient(name notify_account, accounts... remaining_accounts) {
+    require_recipient(notify_account);
+    require_recipient(remaining_accounts...);
+  }
+
+  /// Extracts the current action's data, deserialized as T
+  template<typename T>
+  T unpack_action_data() {
+    constexpr size_t max_stack_buffer_size = 512;
+    size_t size = action_data_size();
+    std::vector<char> buffer(size);
+    read_action_data(buffer.data(), size);
+    (void)max_stack_buffer_size;
+    return unpack<T>(buffer.data(), size);
+  }
+
+  template<typename, name::raw>
+  struct inline_dispatcher;
+
+  template<typename T, name::raw Name, typename... Args>
+  struct inline_dispatcher<void (T::*)(Args...), Name> {
+    static void call(name code, const permission_level& perm, std::tuple<Args...> args) {
+      action(perm, code, name(Name), std::move(args)).send();
+    }
+    static void call(name code, std::vector<permission_level> perms, std::tuple<Args...> args) {
+      action(perms, code, name(Name), std::move(args)).send();
+    }
+  };
+
+} // namespace eosio
+
+#define INLINE_ACTION_SENDER3(CONTRACT_CLASS, FUNCTION_NAME, ACTION_NAME) \
+  ::eosio::inline_dispatcher<decltype(&CONTRACT_CLASS::FUNCTION_NAME), ACTION_NAME>::call
+
+#define INLINE_ACTION_SENDER2(CONTRACT_CLASS, NAME) \
+  INLINE_ACTION_SENDER3(CONTRACT_CLASS, NAME, ::eosio::name(#NAME))
+
+#define INLINE_ACTION_SENDER(CONTRACT_CLASS, NAME) INLINE_ACTION_SENDER2(CONTRACT_CLASS, NAME)
+
+#define SEND_INLINE_ACTION(CONTRACT, NAME, ...) \
+  INLINE_ACTION_SENDER(std::decay_t<decltype(CONTRACT)>, NAME)((CONTRACT).get_self(), __VA_ARGS__);
@@ -0,0 +1,69 @@
+#pragma once
+#include "system.h"
+
+#include <optional>
+#include <utility>
+
+namespace eosio {
+
+  /// Container for a value that is only present at the tail of newer rows or action data.
+  /// Older serialized data simply ends before the field, which reads back as "no value".
+  /// Like eosio.cdt, writing always emits the field, `value_or()` when there is no value, so a
+  /// legacy row that is modified reads back with the default value from then on.
+  template<typename T>
+  class binary_extension {
+  public:
+    using value_type = T;
+
+    constexpr binary_extension() {}
+    constexpr binary_extension(const T& ext) : _value(ext) {}
+    constexpr binary_extension(T&& ext) : _value(std::move(ext)) {}
+
+    constexpr bool has_value() const { return _value.has_value(); }
+
+    constexpr T& value() {
+      eosio_assert(has_value(), "cannot get value of empty binary_extension");
+      return *_value;
+    }
+
+    constexpr const T& value() const {
+      eosio_assert(has_value(), "cannot get value of empty binary_extension");
+      return *_value;
+    }
+
+    constexpr T value_or(const T& def = {}) const { return has_value() ? *_value : def; }
+
+    constexpr T& operator*() { return value(); }
+    constexpr const T& operator*() const { return value(); }
+    constexpr T* operator->() { return &value(); }
+    constexpr const T* operator->() const { return &value(); }
+
+    template<typename... Args>
+    T& emplace(Args&&... args) {
+      _value.emplace(std::forward<Args>(args)...);
+      return *_value;
+    }
+
+    void reset() { _value.reset(); }
+
+    template<typename DataStream>
+    friend DataStream& operator<<(DataStream& ds, const binary_extension& be) {
+      ds << be.value_or();
+      return ds;
+    }
+
+    template<typename DataStream>
+    friend DataStream& operator>>(DataStream& ds, binary_extension& be) {
+      if (ds.remaining()) {
+        T val;
+        ds >> val;
+        be._value = std::move(val);
+      }
+      return ds;
+    }
+
+  private:
+    std::optional<T> _value;
+  };
+
+} // namespace eosio
@@ -0,0 +1,7 @@
+#pragma once
+#include "types.h"
+
+extern "C" {
+  void sha256(const char* data, uint32_t length, capi_checksum256* hash);
+  void assert_sha256(const char* data, uint32_t length, const capi_checksum256* hash);
+}
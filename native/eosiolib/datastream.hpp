@@ -0,0 +1,354 @@
+#pragma once
+#include "system.h"
+#include "varint.hpp"
+#include "reflect.hpp"
+#include "serialize.hpp"
+
+#include <array>
+#include <cstring>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace eosio {
+
+  /// A data stream for reading and writing data in the form of bytes
+  template<typename T>
+  class datastream {
+  public:
+    datastream(T start, size_t s) : _start(start), _pos(start), _end(start + s) {}
+
+    inline void skip(size_t s) { _pos += s; }
+
+    inline bool read(char* d, size_t s) {
+      eosio_assert(size_t(_end - _pos) >= (size_t)s, "read");
+      memcpy(d, _pos, s);
+      _pos += s;
+      return true;
+    }
+
+    inline bool write(const char* d, size_t s) {
+      eosio_assert(_end - _pos >= (int32_t)s, "write");
+      memcpy((void*)_pos, d, s);
+      _pos += s;
+      return true;
+    }
+
+    inline bool put(char c) {
+      eosio_assert(_pos < _end, "put");
+      *_pos = c;
+      ++_pos;
+      return true;
+    }
+
+    inline bool get(unsigned char& c) { return get(*(char*)&c); }
+
+    inline bool get(char& c) {
+      eosio_assert(_pos < _end, "get");
+      c = *_pos;
+      ++_pos;
+      return true;
+    }
+
+    T pos() const { return _pos; }
+    inline bool valid() const { return _pos <= _end && _pos >= _start; }
+    inline bool seekp(size_t p) { _pos = _start + p; return _pos <= _end; }
+    inline size_t tellp() const { return size_t(_pos - _start); }
+    inline size_t remaining() const { return _end - _pos; }
+
+  private:
+    T _start;
+    T _pos;
+    T _end;
+  };
+
+  /// Specialization of datastream used to help determine the final size of a serialized value
+  template<>
+  class datastream<size_t> {
+  public:
+    datastream(size_t init_size = 0) : _size(init_size) {}
+    inline bool skip(size_t s) { _size += s; return true; }
+    inline bool write(const char*, size_t s) { _size += s; return true; }
+    inline bool put(char) { ++_size; return true; }
+    inline bool valid() const { return true; }
+    inline bool seekp(size_t p) { _size = p; return true; }
+    inline size_t tellp() const { return _size; }
+    inline size_t remaining() const { return 0; }
+
+  private:
+    size_t _size;
+  };
+
+  namespace _datastream_detail {
+    template<typename T>
+    constexpr bool is_primitive() {
+      return std::is_arithmetic<T>::value || std::is_enum<T>::value;
+    }
+
+    // Stream type only a class' own serializer accepts: EOSLIB_SERIALIZE and hand written
+    // friend operators are templated on any DataStream, the reflected fallback is not
+    struct probe_stream {};
+
+    template<typename T, typename = void>
+    struct has_friend_serializer : std::false_type {};
+
+    template<typename T>
+    struct has_friend_serializer<T, std::void_t<decltype(operator<<(std::declval<probe_stream&>(), std::declval<const T&>()))>>
+      : std::true_type {};
+
+    // Set for classes that declare EOSLIB_SERIALIZE or their own stream operators
+    template<typename T, typename = void>
+    struct has_member_serializer : has_friend_serializer<T> {};
+
+    template<typename T>
+    struct has_member_serializer<T, std::void_t<typename T::eoslib_serialized_type>>
+      : std::is_same<typename T::eoslib_serialized_type, T> {};
+
+    template<typename T>
+    constexpr bool is_reflected_aggregate() {
+      return std::is_class<T>::value && std::is_aggregate<T>::value && !has_member_serializer<T>::value;
+    }
+  }
+
+  // Arithmetic and enum types are written in their native little-endian representation
+  template<typename Stream, typename T,
+           std::enable_if_t<_datastream_detail::is_primitive<T>()>* = nullptr>
+  datastream<Stream>& operator<<(datastream<Stream>& ds, const T& v) {
+    ds.write((const char*)&v, sizeof(T));
+    return ds;
+  }
+
+  template<typename Stream, typename T,
+           std::enable_if_t<_datastream_detail::is_primitive<T>()>* = nullptr>
+  datastream<Stream>& operator>>(datastream<Stream>& ds, T& v) {
+    ds.read((char*)&v, sizeof(T));
+    return ds;
+  }
+
+  template<typename Stream>
+  datastream<Stream>& operator<<(datastream<Stream>& ds, const bool& d) {
+    return ds << uint8_t(d);
+  }
+
+  template<typename Stream>
+  datastream<Stream>& operator>>(datastream<Stream>& ds, bool& d) {
+    uint8_t t;
+    ds >> t;
+    d = t;
+    return ds;
+  }
+
+  template<typename Stream>
+  datastream<Stream>& operator<<(datastream<Stream>& ds, const std::string& v) {
+    ds << unsigned_int(v.size());
+    if (v.size())
+      ds.write(v.data(), v.size());
+    return ds;
+  }
+
+  template<typename Stream>
+  datastream<Stream>& operator>>(datastream<Stream>& ds, std::string& v) {
+    std::vector<char> tmp;
+    ds >> tmp;
+    if (tmp.size())
+      v = std::string(tmp.data(), tmp.data() + tmp.size());
+    else
+      v = std::string();
+    return ds;
+  }
+
+  template<typename Stream, typename T, std::size_t N>
+  datastream<Stream>& operator<<(datastream<Stream>& ds, const std::array<T, N>& v) {
+    for (const auto& i : v)
+      ds << i;
+    return ds;
+  }
+
+  template<typename Stream, typename T, std::size_t N>
+  datastream<Stream>& operator>>(datastream<Stream>& ds, std::array<T, N>& v) {
+    for (auto& i : v)
+      ds >> i;
+    return ds;
+  }
+
+  template<typename Stream, typename T>
+  datastream<Stream>& operator<<(datastream<Stream>& ds, const std::vector<T>& v) {
+    ds << unsigned_int(v.size());
+    if constexpr (std::is_same<T, char>::value || std::is_same<T, uint8_t>::value) {
+      if (v.size())
+        ds.write((const char*)v.data(), v.size());
+    } else {
+      for (const auto& i : v)
+        ds << i;
+    }
+    return ds;
+  }
+
+  template<typename Stream, typename T>
+  datastream<Stream>& operator>>(datastream<Stream>& ds, std::vector<T>& v) {
+    unsigned_int s;
+    ds >> s;
+    v.resize(s.value);
+    if constexpr (std::is_same<T, char>::value || std::is_same<T, uint8_t>::value) {
+      if (s.value)
+        ds.read((char*)v.data(), v.size());
+    } else {
+      for (auto& i : v)
+        ds >> i;
+    }
+    return ds;
+  }
+
+  template<typename Stream, typename K, typename V>
+  datastream<Stream>& operator<<(datastream<Stream>& ds, const std::map<K, V>& m) {
+    ds << unsigned_int(m.size());
+    for (const auto& i : m)
+      ds << i.first << i.second;
+    return ds;
+  }
+
+  template<typename Stream, typename K, typename V>
+  datastream<Stream>& operator>>(datastream<Stream>& ds, std::map<K, V>& m) {
+    m.clear();
+    unsigned_int s;
+    ds >> s;
+    for (uint32_t i = 0; i < s.value; ++i) {
+      K k; V v;
+      ds >> k >> v;
+      m.emplace(std::move(k), std::move(v));
+    }
+    return ds;
+  }
+
+  template<typename Stream, typename T1, typename T2>
+  datastream<Stream>& operator<<(datastream<Stream>& ds, const std::pair<T1, T2>& t) {
+    ds << t.first << t.second;
+    return ds;
+  }
+
+  template<typename Stream, typename T1, typename T2>
+  datastream<Stream>& operator>>(datastream<Stream>& ds, std::pair<T1, T2>& t) {
+    ds >> t.first >> t.second;
+    return ds;
+  }
+
+  template<typename Stream, typename T>
+  datastream<Stream>& operator<<(datastream<Stream>& ds, const std::optional<T>& opt) {
+    char valid = opt.has_value();
+    ds << valid;
+    if (valid)
+      ds << *opt;
+    return ds;
+  }
+
+  template<typename Stream, typename T>
+  datastream<Stream>& operator>>(datastream<Stream>& ds, std::optional<T>& opt) {
+    char valid = 0;
+    ds >> valid;
+    if (valid) {
+      T val;
+      ds >> val;
+      opt = val;
+    } else {
+      opt.reset();
+    }
+    return ds;
+  }
+
+  template<typename Stream, typename... Args>
+  datastream<Stream>& operator<<(datastream<Stream>& ds, const std::tuple<Args...>& t) {
+    std::apply([&](const auto&... e) { ((ds << e), ...); }, t);
+    return ds;
+  }
+
+  template<typename Stream, typename... Args>
+  datastream<Stream>& operator>>(datastream<Stream>& ds, std::tuple<Args...>& t) {
+    std::apply([&](auto&... e) { ((ds >> e), ...); }, t);
+    return ds;
+  }
+
+  template<typename Stream, typename... Ts>
+  datastream<Stream>& operator<<(datastream<Stream>& ds, const std::variant<Ts...>& var) {
+    unsigned_int index = var.index();
+    ds << index;
+    std::visit([&ds](const auto& val) { ds << val; }, var);
+    return ds;
+  }
+
+  namespace _datastream_detail {
+    template<int I, typename Stream, typename... Ts>
+    void deserialize(Stream& ds, std::variant<Ts...>& var, int i) {
+      if constexpr (I < std::variant_size_v<std::variant<Ts...>>) {
+        if (i == I) {
+          std::variant_alternative_t<I, std::variant<Ts...>> tmp;
+          ds >> tmp;
+          var.template emplace<I>(std::move(tmp));
+        } else {
+          deserialize<I + 1>(ds, var, i);
+        }
+      } else {
+        eosio_assert(false, "invalid variant index");
+      }
+    }
+  }
+
+  template<typename Stream, typename... Ts>
+  datastream<Stream>& operator>>(datastream<Stream>& ds, std::variant<Ts...>& var) {
+    unsigned_int index;
+    ds >> index;
+    _datastream_detail::deserialize<0>(ds, var, index);
+    return ds;
+  }
+
+  // Aggregates without EOSLIB_SERIALIZE are serialized field by field, in declaration
+  // order, like eosio.cdt does through Boost.PFR
+  template<typename Stream, typename T,
+           std::enable_if_t<_datastream_detail::is_reflected_aggregate<T>()>* = nullptr>
+  datastream<Stream>& operator<<(datastream<Stream>& ds, const T& v) {
+    _reflect::for_each_field(v, [&](const auto& field) { ds << field; });
+    return ds;
+  }
+
+  template<typename Stream, typename T,
+           std::enable_if_t<_datastream_detail::is_reflected_aggregate<T>()>* = nullptr>
+  datastream<Stream>& operator>>(datastream<Stream>& ds, T& v) {
+    _reflect::for_each_field(v, [&](auto& field) { ds >> field; });
+    return ds;
+  }
+
+  template<typename T>
+  T unpack(const char* buffer, size_t len) {
+    T result;
+    datastream<const char*> ds(buffer, len);
+    ds >> result;
+    return result;
+  }
+
+  template<typename T>
+  T unpack(const std::vector<char>& bytes) {
+    return unpack<T>(bytes.data(), bytes.size());
+  }
+
+  template<typename T>
+  size_t pack_size(const T& value) {
+    datastream<size_t> ps;
+    ps << value;
+    return ps.tellp();
+  }
+
+  template<typename T>
+  std::vector<char> pack(const T& value) {
+    std::vector<char> result;
+    result.resize(pack_size(value));
+    datastream<char*> ds(result.data(), result.size());
+    ds << value;
+    return result;
+  }
+
+} // namespace eosio
@@ -0,0 +1,40 @@
+#pragma once
+#include "types.h"
+
+#include <string>
+#include <vector>
+
+// Storage interface of the in-memory chain. multi_index and singleton are written on top
+// of these calls the same way eosio.cdt builds them on the db_*_i64 / db_idx* intrinsics.
+namespace eosio { namespace native {
+
+  /// Encoded secondary key plus the primary key it points to, ordered by (key, primary)
+  struct index_entry {
+    std::string key;
+    uint64_t primary = 0;
+  };
+
+  const std::vector<char>* db_get(uint64_t code, uint64_t scope, uint64_t table, uint64_t primary);
+  bool db_lower_bound(uint64_t code, uint64_t scope, uint64_t table, uint64_t primary, uint64_t& found);
+  bool db_upper_bound(uint64_t code, uint64_t scope, uint64_t table, uint64_t primary, uint64_t& found);
+  bool db_previous(uint64_t code, uint64_t scope, uint64_t table, uint64_t primary, uint64_t& found);
+  bool db_last(uint64_t code, uint64_t scope, uint64_t table, uint64_t& found);
+
+  void db_store(uint64_t scope, uint64_t table, uint64_t payer, uint64_t primary, const std::vector<char>& data);
+  void db_update(uint64_t scope, uint64_t table, uint64_t payer, uint64_t primary, const std::vector<char>& data);
+  void db_remove(uint64_t scope, uint64_t table, uint64_t primary);
+
+  bool idx_lower_bound(uint64_t code, uint64_t scope, uint64_t table, uint64_t index,
+                       const std::string& key, uint64_t primary, index_entry& found);
+  bool idx_upper_bound(uint64_t code, uint64_t scope, uint64_t table, uint64_t index,
+                       const std::string& key, index_entry& found);
+  bool idx_next(uint64_t code, uint64_t scope, uint64_t table, uint64_t index,
+                const index_entry& from, index_entry& found);
+  bool idx_previous(uint64_t code, uint64_t scope, uint64_t table, uint64_t index,
+                    const index_entry& from, index_entry& found);
+  bool idx_last(uint64_t code, uint64_t scope, uint64_t table, uint64_t index, index_entry& found);
+
+  void idx_store(uint64_t scope, uint64_t table, uint64_t index, const std::string& key, uint64_t primary);
+  void idx_remove(uint64_t scope, uint64_t table, uint64_t index, const std::string& key, uint64_t primary);
+
+}} // namespace eosio::native
@@ -0,0 +1,62 @@
+#pragma once
+#include "action.hpp"
+#include "datastream.hpp"
+#include "name.hpp"
+
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace eosio {
+
+  /// Unpacks the current action data into the member function's arguments and calls it
+  template<typename T, typename... Args>
+  bool execute_action(name self, name code, void (T::*func)(Args...)) {
+    size_t size = action_data_size();
+    std::vector<char> buffer(size);
+    if (size > 0) {
+      read_action_data(buffer.data(), size);
+    }
+
+    std::tuple<std::decay_t<Args>...> args;
+    datastream<const char*> ds(buffer.data(), size);
+    ds >> args;
+
+    T inst(self, code, ds);
+
+    auto f2 = [&](auto... a) { ((&inst)->*func)(a...); };
+    std::apply(f2, args);
+    return true;
+  }
+
+} // namespace eosio
+
+#define EOSIO_DISPATCH_CASE_A(m) EOSIO_DISPATCH_CASE(m) EOSIO_DISPATCH_CASE_B
+#define EOSIO_DISPATCH_CASE_B(m) EOSIO_DISPATCH_CASE(m) EOSIO_DISPATCH_CASE_A
+#define EOSIO_DISPATCH_CASE_A_END
+#define EOSIO_DISPATCH_CASE_B_END
+
+#define EOSIO_DISPATCH_CASE(elem)                                          \
+  case eosio::name(#elem).value:                                           \
+    eosio::execute_action(eosio::name(receiver), eosio::name(code), &EOSIO_DISPATCH_TYPE::elem); \
+    break;
+
+/// Cases of the given actions, to be used inside a custom apply handler's switch on the action name
+#define EOSIO_DISPATCH_HELPER(TYPE, MEMBERS)                               \
+  using EOSIO_DISPATCH_TYPE = TYPE;                                        \
+  EOSLIB_SEQ_CAT(EOSIO_DISPATCH_CASE_A MEMBERS, _END)
+
+/**
+ * Convenient macro to create contract apply handler. The host build loads each contract
+ * as its own shared object, so every contract keeps the plain `apply` entry point.
+ */
+#define EOSIO_DISPATCH(TYPE, MEMBERS)                                      \
+  extern "C" {                                                             \
+  void apply(uint64_t receiver, uint64_t code, uint64_t action) {          \
+    if (code == receiver) {                                                \
+      switch (action) {                                                    \
+        EOSIO_DISPATCH_HELPER(TYPE, MEMBERS)                               \
+      }                                                                    \
+    }                                                                      \
+  }                                                                        \
+  }
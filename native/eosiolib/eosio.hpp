@@ -0,0 +1,6 @@
+#pragma once
+#include "action.hpp"
+#include "print.hpp"
+#include "multi_index.hpp"
+#include "dispatcher.hpp"
+#include "contract.hpp"
@@ -0,0 +1,52 @@
+#pragma once
+#include "system.h"
+
+#include <array>
+#include <cstring>
+
+namespace eosio {
+
+  /// Fixed size byte array sorted lexicographically, used for checksums and secondary keys
+  template<size_t Size>
+  class fixed_bytes {
+  public:
+    fixed_bytes() { _data.fill(0); }
+
+    fixed_bytes(const std::array<uint8_t, Size>& arr) : _data(arr) {}
+
+    fixed_bytes(const uint8_t (&arr)[Size]) { memcpy(_data.data(), arr, Size); }
+
+    static constexpr size_t size() { return Size; }
+
+    const uint8_t* data() const { return _data.data(); }
+
+    std::array<uint8_t, Size> extract_as_byte_array() const { return _data; }
+
+    friend bool operator==(const fixed_bytes& a, const fixed_bytes& b) { return a._data == b._data; }
+    friend bool operator!=(const fixed_bytes& a, const fixed_bytes& b) { return a._data != b._data; }
+    friend bool operator<(const fixed_bytes& a, const fixed_bytes& b) { return a._data < b._data; }
+    friend bool operator>(const fixed_bytes& a, const fixed_bytes& b) { return a._data > b._data; }
+    friend bool operator<=(const fixed_bytes& a, const fixed_bytes& b) { return a._data <= b._data; }
+    friend bool operator>=(const fixed_bytes& a, const fixed_bytes& b) { return a._data >= b._data; }
+
+    template<typename DataStream>
+    friend DataStream& operator<<(DataStream& ds, const fixed_bytes& d) {
+      ds.write((const char*)d._data.data(), Size);
+      return ds;
+    }
+
+    template<typename DataStream>
+    friend DataStream& operator>>(DataStream& ds, fixed_bytes& d) {
+      ds.read((char*)d._data.data(), Size);
+      return ds;
+    }
+
+  private:
+    std::array<uint8_t, Size> _data;
+  };
+
+  using checksum160 = fixed_bytes<20>;
+  using checksum256 = fixed_bytes<32>;
+  using checksum512 = fixed_bytes<64>;
+
+} // namespace eosio
@@ -0,0 +1,507 @@
+#pragma once
+#include "action.h"
+#include "datastream.hpp"
+#include "db.hpp"
+#include "fixed_bytes.hpp"
+#include "name.hpp"
+#include "system.h"
+
+#include <cstring>
+#include <array>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace eosio {
+
+  namespace _multi_index_detail {
+
+    // Secondary keys are stored as byte strings whose lexicographic order matches the
+    // numeric order of the key, so one ordered container serves every key type.
+    inline std::string to_key(uint64_t v) {
+      std::string k(8, '\0');
+      for (int i = 7; i >= 0; --i, v >>= 8) k[i] = char(v & 0xFF);
+      return k;
+    }
+
+    inline std::string to_key(uint128_t v) {
+      std::string k(16, '\0');
+      for (int i = 15; i >= 0; --i, v >>= 8) k[i] = char(uint8_t(v & 0xFF));
+      return k;
+    }
+
+    inline std::string to_key(double v) {
+      uint64_t bits;
+      memcpy(&bits, &v, sizeof(bits));
+      bits = (bits & (1ull << 63)) ? ~bits : bits | (1ull << 63);
+      return to_key(bits);
+    }
+
+    inline std::string to_key(const fixed_bytes<32>& v) {
+      auto arr = v.extract_as_byte_array();
+      return std::string((const char*)arr.data(), arr.size());
+    }
+
+    template<typename T>
+    struct is_secondary_key_type : std::false_type {};
+    template<> struct is_secondary_key_type<uint64_t> : std::true_type {};
+    template<> struct is_secondary_key_type<uint128_t> : std::true_type {};
+    template<> struct is_secondary_key_type<double> : std::true_type {};
+    template<> struct is_secondary_key_type<fixed_bytes<32>> : std::true_type {};
+
+  } // namespace _multi_index_detail
+
+  /// Defines a secondary index of a multi_index table
+  template<name::raw IndexName, typename Extractor>
+  struct indexed_by {
+    enum constants { index_name = static_cast<uint64_t>(IndexName) };
+    typedef Extractor secondary_extractor_type;
+  };
+
+  /// Extracts a secondary key through a const member function
+  template<class Class, typename Type, Type (Class::*PtrToMemberFunction)() const>
+  struct const_mem_fun {
+    typedef typename std::remove_reference<Type>::type result_type;
+
+    Type operator()(const Class& x) const { return (x.*PtrToMemberFunction)(); }
+  };
+
+  /// In-memory multi_index with the eosio.cdt 1.5 interface. Rows are kept serialized in
+  /// the chain database, and objects are cached per instance like the on-chain version.
+  template<name::raw TableName, typename T, typename... Indices>
+  class multi_index {
+  private:
+    static_assert(sizeof...(Indices) <= 16, "multi_index only supports a maximum of 16 secondary indices");
+
+    constexpr static bool validate_table_name(name::raw n) {
+      return (static_cast<uint64_t>(n) & 0x000000000000000FULL) == 0;
+    }
+
+    static_assert(validate_table_name(TableName), "multi_index does not support table names with a length greater than 12");
+
+    template<size_t I>
+    using index_extractor = typename std::tuple_element<I, std::tuple<Indices...>>::type::secondary_extractor_type;
+
+    template<size_t I>
+    using index_key_type = std::decay_t<decltype(index_extractor<I>()(std::declval<const T&>()))>;
+
+    template<size_t I>
+    static std::string secondary_key(const T& obj) {
+      static_assert(_multi_index_detail::is_secondary_key_type<index_key_type<I>>::value,
+                    "unsupported secondary index key type");
+      return _multi_index_detail::to_key(index_extractor<I>()(obj));
+    }
+
+    template<uint64_t IndexName, size_t I = 0>
+    static constexpr size_t index_number() {
+      static_assert(I < sizeof...(Indices), "name not found in list of indices");
+      if constexpr (std::tuple_element<I, std::tuple<Indices...>>::type::index_name == IndexName)
+        return I;
+      else
+        return index_number<IndexName, I + 1>();
+    }
+
+    name _code;
+    uint64_t _scope;
+    mutable std::map<uint64_t, std::unique_ptr<T>> _items;
+
+    const T& load(uint64_t primary) const {
+      auto cached = _items.find(primary);
+      if (cached != _items.end())
+        return *cached->second;
+
+      const auto* data = native::db_get(_code.value, _scope, static_cast<uint64_t>(TableName), primary);
+      eosio_assert(data != nullptr, "unable to find key");
+
+      auto obj = std::make_unique<T>();
+      datastream<const char*> ds(data->data(), data->size());
+      ds >> *obj;
+
+      auto& result = *obj;
+      _items.emplace(primary, std::move(obj));
+      return result;
+    }
+
+    template<size_t... I>
+    void store_secondaries(const T& obj, std::index_sequence<I...>) {
+      (native::idx_store(_scope, static_cast<uint64_t>(TableName), I, secondary_key<I>(obj), obj.primary_key()), ...);
+    }
+
+    template<size_t... I>
+    void remove_secondaries(const T& obj, std::index_sequence<I...>) {
+      (native::idx_remove(_scope, static_cast<uint64_t>(TableName), I, secondary_key<I>(obj), obj.primary_key()), ...);
+    }
+
+    template<size_t... I>
+    std::array<std::string, sizeof...(Indices)> secondary_keys(const T& obj, std::index_sequence<I...>) const {
+      return {{ secondary_key<I>(obj)... }};
+    }
+
+  public:
+    class const_iterator {
+    public:
+      using iterator_category = std::bidirectional_iterator_tag;
+      using value_type = const T;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const T*;
+      using reference = const T&;
+
+      const_iterator() {}
+
+      reference operator*() const {
+        eosio_assert(!_end, "cannot dereference end iterator");
+        return _multidx->load(_primary);
+      }
+      pointer operator->() const { return &**this; }
+
+      const_iterator operator++(int) {
+        const_iterator result(*this);
+        ++(*this);
+        return result;
+      }
+
+      const_iterator operator--(int) {
+        const_iterator result(*this);
+        --(*this);
+        return result;
+      }
+
+      const_iterator& operator++() {
+        eosio_assert(!_end, "cannot increment end iterator");
+        uint64_t next;
+        if (native::db_upper_bound(_multidx->_code.value, _multidx->_scope, static_cast<uint64_t>(TableName), _primary, next))
+          _primary = next;
+        else
+          _end = true;
+        return *this;
+      }
+
+      const_iterator& operator--() {
+        uint64_t prev;
+        bool found = _end
+          ? native::db_last(_multidx->_code.value, _multidx->_scope, static_cast<uint64_t>(TableName), prev)
+          : native::db_previous(_multidx->_code.value, _multidx->_scope, static_cast<uint64_t>(TableName), _primary, prev);
+        eosio_assert(found, "cannot decrement iterator at beginning of table");
+        _primary = prev;
+        _end = false;
+        return *this;
+      }
+
+      friend bool operator==(const const_iterator& a, const const_iterator& b) {
+        return a._multidx == b._multidx && a._end == b._end && (a._end || a._primary == b._primary);
+      }
+      friend bool operator!=(const const_iterator& a, const const_iterator& b) { return !(a == b); }
+
+    private:
+      friend class multi_index;
+
+      const_iterator(const multi_index* mi, uint64_t primary) : _multidx(mi), _primary(primary), _end(false) {}
+      explicit const_iterator(const multi_index* mi) : _multidx(mi), _end(true) {}
+
+      const multi_index* _multidx = nullptr;
+      uint64_t _primary = 0;
+      bool _end = true;
+    };
+
+    typedef const_iterator iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    template<size_t Number>
+    class index {
+    public:
+      typedef index_key_type<Number> secondary_key_type;
+
+      class const_iterator {
+      public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = const T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() {}
+
+        reference operator*() const {
+          eosio_assert(!_end, "cannot dereference end iterator");
+          return _multidx->load(_entry.primary);
+        }
+        pointer operator->() const { return &**this; }
+
+        const_iterator operator++(int) {
+          const_iterator result(*this);
+          ++(*this);
+          return result;
+        }
+
+        const_iterator operator--(int) {
+          const_iterator result(*this);
+          --(*this);
+          return result;
+        }
+
+        const_iterator& operator++() {
+          eosio_assert(!_end, "cannot increment end iterator");
+          native::index_entry next;
+          if (native::idx_next(_multidx->_code.value, _multidx->_scope, static_cast<uint64_t>(TableName), Number, _entry, next))
+            _entry = next;
+          else
+            _end = true;
+          return *this;
+        }
+
+        const_iterator& operator--() {
+          native::index_entry prev;
+          bool found = _end
+            ? native::idx_last(_multidx->_code.value, _multidx->_scope, static_cast<uint64_t>(TableName), Number, prev)
+            : native::idx_previous(_multidx->_code.value, _multidx->_scope, static_cast<uint64_t>(TableName), Number, _entry, prev);
+          eosio_assert(found, "cannot decrement iterator at beginning of index");
+          _entry = prev;
+          _end = false;
+          return *this;
+        }
+
+        friend bool operator==(const const_iterator& a, const const_iterator& b) {
+          return a._multidx == b._multidx && a._end == b._end &&
+                 (a._end || (a._entry.primary == b._entry.primary && a._entry.key == b._entry.key));
+        }
+        friend bool operator!=(const const_iterator& a, const const_iterator& b) { return !(a == b); }
+
+      private:
+        friend class index;
+
+        const_iterator(const multi_index* mi, const native::index_entry& entry) : _multidx(mi), _entry(entry), _end(false) {}
+        explicit const_iterator(const multi_index* mi) : _multidx(mi), _end(true) {}
+
+        const multi_index* _multidx = nullptr;
+        native::index_entry _entry;
+        bool _end = true;
+      };
+
+      typedef const_iterator iterator;
+      typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+      explicit index(multi_index* mi) : _multidx(mi) {}
+
+      const_iterator cbegin() const { return lower_bound_encoded(std::string()); }
+      const_iterator begin() const { return cbegin(); }
+      const_iterator cend() const { return const_iterator(_multidx); }
+      const_iterator end() const { return cend(); }
+
+      const_reverse_iterator crbegin() const { return std::make_reverse_iterator(cend()); }
+      const_reverse_iterator rbegin() const { return crbegin(); }
+      const_reverse_iterator crend() const { return std::make_reverse_iterator(cbegin()); }
+      const_reverse_iterator rend() const { return crend(); }
+
+      const_iterator find(secondary_key_type&& secondary) const {
+        auto lb = lower_bound(secondary);
+        auto e = cend();
+        if (lb == e) return e;
+        if (secondary != index_extractor<Number>()(*lb)) return e;
+        return lb;
+      }
+
+      const_iterator find(const secondary_key_type& secondary) const {
+        auto lb = lower_bound(secondary);
+        auto e = cend();
+        if (lb == e) return e;
+        if (secondary != index_extractor<Number>()(*lb)) return e;
+        return lb;
+      }
+
+      const T& get(const secondary_key_type& secondary, const char* error_msg = "unable to find secondary key") const {
+        auto result = find(secondary);
+        eosio_assert(result != cend(), error_msg);
+        return *result;
+      }
+
+      const_iterator lower_bound(const secondary_key_type& secondary) const {
+        return lower_bound_encoded(_multi_index_detail::to_key(secondary));
+      }
+
+      const_iterator upper_bound(const secondary_key_type& secondary) const {
+        native::index_entry found;
+        if (native::idx_upper_bound(_multidx->_code.value, _multidx->_scope, static_cast<uint64_t>(TableName), Number,
+                                    _multi_index_detail::to_key(secondary), found))
+          return const_iterator(_multidx, found);
+        return cend();
+      }
+
+      const_iterator iterator_to(const T& obj) const {
+        return const_iterator(_multidx, native::index_entry{secondary_key<Number>(obj), obj.primary_key()});
+      }
+
+      template<typename Lambda>
+      void modify(const_iterator itr, eosio::name payer, Lambda&& updater) {
+        eosio_assert(itr != cend(), "cannot pass end iterator to modify");
+        _multidx->modify(*itr, payer, std::forward<Lambda&&>(updater));
+      }
+
+      const_iterator erase(const_iterator itr) {
+        eosio_assert(itr != cend(), "cannot pass end iterator to erase");
+        const auto& obj = *itr;
+        ++itr;
+        _multidx->erase(obj);
+        return itr;
+      }
+
+      eosio::name get_code() const { return _multidx->get_code(); }
+      uint64_t get_scope() const { return _multidx->get_scope(); }
+
+      static constexpr uint64_t name() {
+        return std::tuple_element<Number, std::tuple<Indices...>>::type::index_name;
+      }
+
+    private:
+      const_iterator lower_bound_encoded(const std::string& key) const {
+        native::index_entry found;
+        if (native::idx_lower_bound(_multidx->_code.value, _multidx->_scope, static_cast<uint64_t>(TableName), Number, key, 0, found))
+          return const_iterator(_multidx, found);
+        return cend();
+      }
+
+      multi_index* _multidx;
+    };
+
+    multi_index(name code, uint64_t scope) : _code(code), _scope(scope) {}
+
+    multi_index(const multi_index&) = delete;
+    multi_index& operator=(const multi_index&) = delete;
+
+    name get_code() const { return _code; }
+    uint64_t get_scope() const { return _scope; }
+
+    const_iterator cbegin() const { return lower_bound(std::numeric_limits<uint64_t>::lowest()); }
+    const_iterator begin() const { return cbegin(); }
+    const_iterator cend() const { return const_iterator(this); }
+    const_iterator end() const { return cend(); }
+
+    const_reverse_iterator crbegin() const { return std::make_reverse_iterator(cend()); }
+    const_reverse_iterator rbegin() const { return crbegin(); }
+    const_reverse_iterator crend() const { return std::make_reverse_iterator(cbegin()); }
+    const_reverse_iterator rend() const { return crend(); }
+
+    const_iterator lower_bound(uint64_t primary) const {
+      uint64_t found;
+      if (native::db_lower_bound(_code.value, _scope, static_cast<uint64_t>(TableName), primary, found))
+        return const_iterator(this, found);
+      return cend();
+    }
+
+    const_iterator upper_bound(uint64_t primary) const {
+      uint64_t found;
+      if (native::db_upper_bound(_code.value, _scope, static_cast<uint64_t>(TableName), primary, found))
+        return const_iterator(this, found);
+      return cend();
+    }
+
+    uint64_t available_primary_key() const {
+      uint64_t last;
+      if (!native::db_last(_code.value, _scope, static_cast<uint64_t>(TableName), last))
+        return 0;
+      eosio_assert(last + 1 < std::numeric_limits<uint64_t>::max(), "next primary key in table is at autoincrement limit");
+      return last + 1;
+    }
+
+    template<name::raw IndexName>
+    auto get_index() {
+      return index<index_number<static_cast<uint64_t>(IndexName)>()>(this);
+    }
+
+    template<name::raw IndexName>
+    auto get_index() const {
+      return index<index_number<static_cast<uint64_t>(IndexName)>()>(const_cast<multi_index*>(this));
+    }
+
+    const_iterator iterator_to(const T& obj) const {
+      return const_iterator(this, obj.primary_key());
+    }
+
+    template<typename Lambda>
+    const_iterator emplace(name payer, Lambda&& constructor) {
+      eosio_assert(_code.value == current_receiver(), "cannot create objects in table of another contract");
+
+      auto obj = std::make_unique<T>();
+      constructor(*obj);
+
+      uint64_t primary = obj->primary_key();
+      native::db_store(_scope, static_cast<uint64_t>(TableName), payer.value, primary, pack(*obj));
+      store_secondaries(*obj, std::index_sequence_for<Indices...>{});
+
+      _items[primary] = std::move(obj);
+      return const_iterator(this, primary);
+    }
+
+    template<typename Lambda>
+    void modify(const_iterator itr, name payer, Lambda&& updater) {
+      eosio_assert(itr != end(), "cannot pass end iterator to modify");
+      modify(*itr, payer, std::forward<Lambda&&>(updater));
+    }
+
+    template<typename Lambda>
+    void modify(const T& obj, name payer, Lambda&& updater) {
+      eosio_assert(_code.value == current_receiver(), "cannot modify objects in table of another contract");
+
+      uint64_t primary = obj.primary_key();
+      auto cached = _items.find(primary);
+      eosio_assert(cached != _items.end() && cached->second.get() == &obj, "object passed to modify is not in multi_index");
+
+      auto old_keys = secondary_keys(obj, std::index_sequence_for<Indices...>{});
+
+      auto& mutableobj = const_cast<T&>(obj);
+      updater(mutableobj);
+
+      eosio_assert(primary == obj.primary_key(), "updater cannot change primary key when modifying an object");
+
+      native::db_update(_scope, static_cast<uint64_t>(TableName), payer.value, primary, pack(obj));
+
+      auto new_keys = secondary_keys(obj, std::index_sequence_for<Indices...>{});
+      for (size_t i = 0; i < old_keys.size(); ++i) {
+        if (old_keys[i] != new_keys[i]) {
+          native::idx_remove(_scope, static_cast<uint64_t>(TableName), i, old_keys[i], primary);
+          native::idx_store(_scope, static_cast<uint64_t>(TableName), i, new_keys[i], primary);
+        }
+      }
+    }
+
+    const T& get(uint64_t primary, const char* error_msg = "unable to find key") const {
+      auto result = find(primary);
+      eosio_assert(result != cend(), error_msg);
+      return *result;
+    }
+
+    const_iterator find(uint64_t primary) const {
+      if (_items.count(primary))
+        return const_iterator(this, primary);
+      if (native::db_get(_code.value, _scope, static_cast<uint64_t>(TableName), primary) == nullptr)
+        return cend();
+      load(primary);
+      return const_iterator(this, primary);
+    }
+
+    const_iterator erase(const_iterator itr) {
+      eosio_assert(itr != end(), "cannot pass end iterator to erase");
+      const auto& obj = *itr;
+      ++itr;
+      erase(obj);
+      return itr;
+    }
+
+    void erase(const T& obj) {
+      eosio_assert(_code.value == current_receiver(), "cannot erase objects in table of another contract");
+
+      uint64_t primary = obj.primary_key();
+      auto cached = _items.find(primary);
+      eosio_assert(cached != _items.end() && cached->second.get() == &obj, "object passed to erase is not in multi_index");
+
+      remove_secondaries(obj, std::index_sequence_for<Indices...>{});
+      native::db_remove(_scope, static_cast<uint64_t>(TableName), primary);
+      _items.erase(cached);
+    }
+  };
+
+} // namespace eosio
@@ -0,0 +1,10 @@
+#pragma once
+#include "types.h"
+
+extern "C" {
+  void prints(const char* cstr);
+  void prints_l(const char* cstr, uint32_t len);
+  void printi(int64_t value);
+  void printui(uint64_t value);
+  void printn(uint64_t name);
+}
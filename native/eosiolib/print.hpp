@@ -0,0 +1,55 @@
+#pragma once
+#include "print.h"
+#include "name.hpp"
+#include "symbol.hpp"
+#include "asset.hpp"
+
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace eosio {
+
+  inline void print(const char* ptr) { prints(ptr); }
+  inline void print(const std::string& s) { prints_l(s.c_str(), s.size()); }
+  inline void print(std::string& s) { prints_l(s.c_str(), s.size()); }
+  inline void print(const char c) { prints_l(&c, 1); }
+  inline void print(bool val) { prints(val ? "true" : "false"); }
+  inline void print(name n) { printn(n.value); }
+  inline void print(symbol_code sc) { print(sc.to_string()); }
+  inline void print(symbol s) { print(s.to_string()); }
+  inline void print(const asset& a) { print(a.to_string()); }
+
+  template<typename T, std::enable_if_t<std::is_integral<std::decay_t<T>>::value>* = nullptr>
+  inline void print(T num) {
+    if constexpr (std::is_signed<std::decay_t<T>>::value)
+      printi(num);
+    else
+      printui(num);
+  }
+
+  template<typename Arg, typename... Args>
+  void print(Arg&& a, Args&&... args) {
+    print(std::forward<Arg>(a));
+    print(std::forward<Args>(args)...);
+  }
+
+  /// Prints a format string, substituting each `%` with the next argument
+  inline void print_f(const char* s) {
+    prints(s);
+  }
+
+  template<typename Arg, typename... Args>
+  inline void print_f(const char* s, Arg val, Args... rest) {
+    while (s && *s) {
+      if (*s == '%') {
+        print(val);
+        print_f(s + 1, rest...);
+        return;
+      }
+      prints_l(s, 1);
+      s++;
+    }
+  }
+
+} // namespace eosio
@@ -0,0 +1,63 @@
+#pragma once
+#include <type_traits>
+#include <utility>
+
+// Field-by-field visitation of plain aggregates. eosio.cdt relies on Boost.PFR so that
+// tables without EOSLIB_SERIALIZE still serialize in declaration order; this is the
+// same idea, limited to the aggregate sizes that appear in contract tables.
+namespace eosio { namespace _reflect {
+
+  struct any_field {
+    template<typename T> constexpr operator T() const noexcept;
+  };
+
+  template<typename T, typename Seq, typename = void>
+  struct is_constructible_n : std::false_type {};
+
+  template<typename T, std::size_t... I>
+  struct is_constructible_n<T, std::index_sequence<I...>,
+                            std::void_t<decltype(T{ (void(I), any_field{})... })>> : std::true_type {};
+
+  template<typename T, std::size_t N = 16>
+  constexpr std::size_t field_count() {
+    if constexpr (N == 0) {
+      return 0;
+    } else if constexpr (is_constructible_n<T, std::make_index_sequence<N>>::value) {
+      return N;
+    } else {
+      return field_count<T, N - 1>();
+    }
+  }
+
+#define EOSLIB_REFLECT_VISIT(N, ...)                     \
+  if constexpr (count == N) {                             \
+    auto& [__VA_ARGS__] = t;                              \
+    fold(__VA_ARGS__);                                    \
+  }
+
+  template<typename T, typename F>
+  void for_each_field(T& t, F&& f) {
+    constexpr std::size_t count = field_count<std::remove_const_t<T>>();
+    static_assert(count > 0 && count <= 16, "unsupported aggregate, add EOSLIB_SERIALIZE");
+    auto fold = [&](auto&... fields) { (f(fields), ...); };
+    EOSLIB_REFLECT_VISIT(1, a1)
+    EOSLIB_REFLECT_VISIT(2, a1, a2)
+    EOSLIB_REFLECT_VISIT(3, a1, a2, a3)
+    EOSLIB_REFLECT_VISIT(4, a1, a2, a3, a4)
+    EOSLIB_REFLECT_VISIT(5, a1, a2, a3, a4, a5)
+    EOSLIB_REFLECT_VISIT(6, a1, a2, a3, a4, a5, a6)
+    EOSLIB_REFLECT_VISIT(7, a1, a2, a3, a4, a5, a6, a7)
+    EOSLIB_REFLECT_VISIT(8, a1, a2, a3, a4, a5, a6, a7, a8)
+    EOSLIB_REFLECT_VISIT(9, a1, a2, a3, a4, a5, a6, a7, a8, a9)
+    EOSLIB_REFLECT_VISIT(10, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10)
+    EOSLIB_REFLECT_VISIT(11, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11)
+    EOSLIB_REFLECT_VISIT(12, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12)
+    EOSLIB_REFLECT_VISIT(13, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13)
+    EOSLIB_REFLECT_VISIT(14, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14)
+    EOSLIB_REFLECT_VISIT(15, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15)
+    EOSLIB_REFLECT_VISIT(16, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16)
+  }
+
+#undef EOSLIB_REFLECT_VISIT
+
+}} // namespace eosio::_reflect
@@ -0,0 +1,43 @@
+#pragma once
+
+// Sequence iteration over `(a)(b)(c)` without Boost.Preprocessor.
+#define EOSLIB_SEQ_CAT_I(a, b) a ## b
+#define EOSLIB_SEQ_CAT(a, b) EOSLIB_SEQ_CAT_I(a, b)
+#define EOSLIB_SEQ_OUT_A(m) << t.m EOSLIB_SEQ_OUT_B
+#define EOSLIB_SEQ_OUT_B(m) << t.m EOSLIB_SEQ_OUT_A
+#define EOSLIB_SEQ_OUT_A_END
+#define EOSLIB_SEQ_OUT_B_END
+#define EOSLIB_SEQ_IN_A(m) >> t.m EOSLIB_SEQ_IN_B
+#define EOSLIB_SEQ_IN_B(m) >> t.m EOSLIB_SEQ_IN_A
+#define EOSLIB_SEQ_IN_A_END
+#define EOSLIB_SEQ_IN_B_END
+
+/**
+ *  Defines serialization and deserialization for a class
+ *
+ *  @param TYPE - the class to have its serialization and deserialization defined
+ *  @param MEMBERS - a sequence of member names.  (field1)(field2)(field3)
+ */
+#define EOSLIB_SERIALIZE(TYPE, MEMBERS)                                 \
+  typedef TYPE eoslib_serialized_type;                                  \
+  template<typename DataStream>                                         \
+  friend DataStream& operator<<(DataStream& ds, const TYPE& t) {        \
+    return ds EOSLIB_SEQ_CAT(EOSLIB_SEQ_OUT_A MEMBERS, _END);            \
+  }                                                                     \
+  template<typename DataStream>                                         \
+  friend DataStream& operator>>(DataStream& ds, TYPE& t) {              \
+    return ds EOSLIB_SEQ_CAT(EOSLIB_SEQ_IN_A MEMBERS, _END);             \
+  }
+
+#define EOSLIB_SERIALIZE_DERIVED(TYPE, BASE, MEMBERS)                   \
+  typedef TYPE eoslib_serialized_type;                                  \
+  template<typename DataStream>                                         \
+  friend DataStream& operator<<(DataStream& ds, const TYPE& t) {        \
+    ds << static_cast<const BASE&>(t);                                  \
+    return ds EOSLIB_SEQ_CAT(EOSLIB_SEQ_OUT_A MEMBERS, _END);            \
+  }                                                                     \
+  template<typename DataStream>                                         \
+  friend DataStream& operator>>(DataStream& ds, TYPE& t) {              \
+    ds >> static_cast<BASE&>(t);                                        \
+    return ds EOSLIB_SEQ_CAT(EOSLIB_SEQ_IN_A MEMBERS, _END);             \
+  }
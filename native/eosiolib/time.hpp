@@ -0,0 +1,27 @@
+#pragma once
+#include "system.h"
+#include "serialize.hpp"
+
+namespace eosio {
+
+  /// A lower resolution time_point accurate only to seconds from 1970
+  class time_point_sec {
+  public:
+    time_point_sec() : utc_seconds(0) {}
+    explicit time_point_sec(uint32_t seconds) : utc_seconds(seconds) {}
+
+    static time_point_sec maximum() { return time_point_sec(0xffffffff); }
+    static time_point_sec min() { return time_point_sec(0); }
+
+    uint32_t sec_since_epoch() const { return utc_seconds; }
+
+    friend bool operator==(const time_point_sec& a, const time_point_sec& b) { return a.utc_seconds == b.utc_seconds; }
+    friend bool operator!=(const time_point_sec& a, const time_point_sec& b) { return a.utc_seconds != b.utc_seconds; }
+    friend bool operator<(const time_point_sec& a, const time_point_sec& b) { return a.utc_seconds < b.utc_seconds; }
+
+    uint32_t utc_seconds;
+
+    EOSLIB_SERIALIZE(time_point_sec, (utc_seconds))
+  };
+
+} // namespace eosio
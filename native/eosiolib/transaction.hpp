@@ -0,0 +1,56 @@
+#pragma once
+#include "action.hpp"
+#include "time.hpp"
+#include "varint.hpp"
+#include "serialize.hpp"
+
+#include <vector>
+
+extern "C" {
+  void send_deferred(const uint128_t& sender_id, capi_name payer, const char* serialized_transaction, size_t size, uint32_t replace_existing);
+  int cancel_deferred(const uint128_t& sender_id);
+}
+
+namespace eosio {
+
+  typedef std::tuple<uint16_t, std::vector<char>> extension;
+  typedef std::vector<extension> extensions_type;
+
+  /// Contains details about the transaction
+  class transaction_header {
+  public:
+    transaction_header(time_point_sec exp = time_point_sec(now() + 60))
+      : expiration(exp) {}
+
+    time_point_sec expiration;
+    uint16_t ref_block_num = 0;
+    uint32_t ref_block_prefix = 0;
+    unsigned_int max_net_usage_words = 0UL; /// number of 8 byte words this transaction can serialize into after compressions
+    uint8_t max_cpu_usage_ms = 0UL;         /// number of CPU usage units to bill transaction for
+    unsigned_int delay_sec = 0UL;           /// number of seconds to delay transaction, default: 0
+
+    EOSLIB_SERIALIZE(transaction_header, (expiration)(ref_block_num)(ref_block_prefix)(max_net_usage_words)(max_cpu_usage_ms)(delay_sec))
+  };
+
+  /// Class transaction contains the actions, context_free_actions and extensions type for a transaction
+  class transaction : public transaction_header {
+  public:
+    transaction(time_point_sec exp = time_point_sec(now() + 60)) : transaction_header(exp) {}
+
+    void send(const uint128_t& sender_id, name payer, bool replace_existing = false) const {
+      auto serialize = pack(*this);
+      send_deferred(sender_id, payer.value, serialize.data(), serialize.size(), replace_existing);
+    }
+
+    std::vector<action> context_free_actions;
+    std::vector<action> actions;
+    extensions_type transaction_extensions;
+
+    EOSLIB_SERIALIZE_DERIVED(transaction, transaction_header, (context_free_actions)(actions)(transaction_extensions))
+  };
+
+  inline int cancel_deferred(const uint128_t& sender_id) {
+    return ::cancel_deferred(sender_id);
+  }
+
+} // namespace eosio
@@ -0,0 +1,12 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+typedef __uint128_t uint128_t;
+typedef __int128_t int128_t;
+
+typedef uint64_t capi_name;
+
+struct __attribute__((aligned(16))) capi_checksum256 { uint8_t hash[32]; };
+struct __attribute__((aligned(16))) capi_checksum160 { uint8_t hash[20]; };
+struct __attribute__((aligned(16))) capi_checksum512 { uint8_t hash[64]; };
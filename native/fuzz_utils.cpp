@@ -0,0 +1,106 @@
+#include "../utils/utils.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+   Fuzz target for the parsing and formatting helpers in utils/utils.hpp.
+
+   Checks that splitting a string and joining its items gives the input back, that
+   `is_valid_name` accepts exactly the strings `eosio::name` reads and prints back unchanged,
+   and that `format_uint64` matches `std::to_string`. Any mismatch aborts.
+
+   Built with libFuzzer (`-fsanitize=fuzzer -DBESPIRAL_LIBFUZZER`) it only provides the target.
+   Otherwise it has its own driver: `fuzz_utils file...` runs the given inputs and
+   `fuzz_utils -n runs` runs random ones.
+*/
+
+namespace {
+
+  void check(bool condition, const char* what) {
+    if (!condition) {
+      std::fprintf(stderr, "fuzz_utils: %s\n", what);
+      std::abort();
+    }
+  }
+
+  // Same check as is_valid_name, going through eosio::name for strings it can read
+  bool reads_back(std::string_view str) {
+    if (str.empty() || str.size() > 13) return false;
+    for (std::size_t i = 0; i < str.size(); i++) {
+      char c = str[i];
+      if (c != '.' && !(c >= '1' && c <= '5') && !(c >= 'a' && c <= 'z')) return false;
+    }
+    if (str.size() == 13 && str[12] > 'j') return false;
+
+    return eosio::name(str).to_string() == str;
+  }
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  std::string_view input(reinterpret_cast<const char*>(data), size);
+
+  // The first byte picks the delimiter, the rest is the list
+  std::string_view delim = size > 0 && data[0] % 4 == 0 ? "--" : "-";
+  std::string_view list = size > 0 ? input.substr(1) : input;
+
+  auto items = split(list, delim);
+  std::string joined;
+  for (std::size_t i = 0; i < items.size(); i++) {
+    if (i > 0) joined += delim;
+    joined += items[i];
+    check(items[i].data() >= list.data() && items[i].data() + items[i].size() <= list.data() + list.size(),
+          "split returned a view outside of its input");
+    check(is_valid_name(items[i]) == reads_back(items[i]), "is_valid_name disagrees with eosio::name");
+  }
+  check(joined == list, "split items don't join back into the input");
+  check(items.empty() == list.empty(), "split of a non empty string must have items");
+
+  uint64_t value = 0;
+  std::memcpy(&value, data, std::min(size, sizeof(value)));
+  char buffer[uint64_digits];
+  check(format_uint64(buffer, value) == std::to_string(value), "format_uint64 disagrees with std::to_string");
+
+  return 0;
+}
+
+#ifndef BESPIRAL_LIBFUZZER
+int main(int argc, char** argv) {
+  if (argc == 3 && std::strcmp(argv[1], "-n") == 0) {
+    // Inputs biased towards name characters and delimiters, so names are valid often enough
+    static const char alphabet[] = "abcdejkz12345.-0A";
+    std::mt19937_64 rng(42);
+    uint64_t runs = std::strtoull(argv[2], nullptr, 10);
+
+    for (uint64_t r = 0; r < runs; r++) {
+      std::vector<uint8_t> input(rng() % 64);
+      for (auto& b : input)
+        b = rng() % 8 == 0 ? uint8_t(rng()) : alphabet[rng() % (sizeof(alphabet) - 1)];
+      LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+    std::printf("%llu random inputs passed\n", (unsigned long long)runs);
+    return 0;
+  }
+
+  if (argc < 2) {
+    std::fprintf(stderr, "usage: fuzz_utils file... | fuzz_utils -n runs\n");
+    return 1;
+  }
+
+  for (int i = 1; i < argc; i++) {
+    std::ifstream in(argv[i], std::ios::binary);
+    std::vector<uint8_t> input((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    LLVMFuzzerTestOneInput(input.data(), input.size());
+  }
+  std::printf("%d inputs passed\n", argc - 1);
+  return 0;
+}
+#endif
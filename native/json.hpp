@@ -0,0 +1,247 @@
+#pragma once
+
+#include <cctype>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace eosio { namespace native {
+
+  /// Minimal JSON document, enough to read action traces exported by history nodes
+  struct json {
+    enum kind_t { null, boolean, number, string, array, object };
+
+    kind_t kind = null;
+    bool flag = false;
+    std::string text; // Numbers keep their source text, strings their unescaped value
+    std::vector<json> items;
+    std::map<std::string, json> members;
+
+    bool is_object() const { return kind == object; }
+
+    /// Member lookup that tolerates missing keys and non objects
+    const json* find(const std::string& key) const {
+      if (kind != object)
+        return nullptr;
+      auto itr = members.find(key);
+      return itr == members.end() ? nullptr : &itr->second;
+    }
+
+    const std::string& as_string() const {
+      if (kind != string && kind != number)
+        throw std::runtime_error("expected a json string");
+      return text;
+    }
+  };
+
+  /// Parses JSON values one after another from a buffer, as in a JSON lines file
+  class json_reader {
+  public:
+    json_reader(const char* begin, const char* end) : _pos(begin), _end(end) {}
+
+    /// Skips whitespace and reports whether another value follows
+    bool more() {
+      skip_space();
+      return _pos < _end;
+    }
+
+    json next() {
+      skip_space();
+      return value();
+    }
+
+    /// Used to read a top level array one element at a time instead of as a whole
+    bool enter_array() {
+      skip_space();
+      if (_pos < _end && *_pos == '[') {
+        ++_pos;
+        _in_array = true;
+      }
+      return _in_array;
+    }
+
+    bool more_in_array() {
+      skip_space();
+      if (_pos < _end && *_pos == ',') {
+        ++_pos;
+        skip_space();
+      }
+      if (_pos < _end && *_pos == ']') {
+        ++_pos;
+        return false;
+      }
+      return _pos < _end;
+    }
+
+  private:
+    [[noreturn]] void fail(const char* what) const {
+      throw std::runtime_error(std::string("invalid json: ") + what);
+    }
+
+    void skip_space() {
+      while (_pos < _end && (*_pos == ' ' || *_pos == '\n' || *_pos == '\r' || *_pos == '\t'))
+        ++_pos;
+    }
+
+    bool consume(const char* literal) {
+      const char* p = _pos;
+      for (; *literal; ++literal, ++p) {
+        if (p >= _end || *p != *literal)
+          return false;
+      }
+      _pos = p;
+      return true;
+    }
+
+    json value() {
+      if (_pos >= _end)
+        fail("unexpected end of input");
+
+      json v;
+      switch (*_pos) {
+      case '{':
+        v.kind = json::object;
+        ++_pos;
+        skip_space();
+        if (_pos < _end && *_pos == '}') {
+          ++_pos;
+          return v;
+        }
+        while (true) {
+          skip_space();
+          std::string key = string_value();
+          skip_space();
+          if (_pos >= _end || *_pos++ != ':')
+            fail("expected ':'");
+          skip_space();
+          v.members[std::move(key)] = value();
+          skip_space();
+          if (_pos < _end && *_pos == ',') {
+            ++_pos;
+            continue;
+          }
+          if (_pos < _end && *_pos == '}') {
+            ++_pos;
+            return v;
+          }
+          fail("expected ',' or '}'");
+        }
+      case '[':
+        v.kind = json::array;
+        ++_pos;
+        skip_space();
+        if (_pos < _end && *_pos == ']') {
+          ++_pos;
+          return v;
+        }
+        while (true) {
+          skip_space();
+          v.items.push_back(value());
+          skip_space();
+          if (_pos < _end && *_pos == ',') {
+            ++_pos;
+            continue;
+          }
+          if (_pos < _end && *_pos == ']') {
+            ++_pos;
+            return v;
+          }
+          fail("expected ',' or ']'");
+        }
+      case '"':
+        v.kind = json::string;
+        v.text = string_value();
+        return v;
+      case 't':
+      case 'f':
+        v.kind = json::boolean;
+        v.flag = *_pos == 't';
+        if (!consume(v.flag ? "true" : "false"))
+          fail("bad literal");
+        return v;
+      case 'n':
+        if (!consume("null"))
+          fail("bad literal");
+        return v;
+      default:
+        v.kind = json::number;
+        while (_pos < _end && (isdigit((unsigned char)*_pos) || *_pos == '-' || *_pos == '+' ||
+                               *_pos == '.' || *_pos == 'e' || *_pos == 'E'))
+          v.text += *_pos++;
+        if (v.text.empty())
+          fail("unexpected character");
+        return v;
+      }
+    }
+
+    std::string string_value() {
+      if (_pos >= _end || *_pos != '"')
+        fail("expected a string");
+      ++_pos;
+
+      std::string out;
+      while (_pos < _end && *_pos != '"') {
+        char c = *_pos++;
+        if (c != '\\') {
+          out += c;
+          continue;
+        }
+        if (_pos >= _end)
+          fail("unterminated escape");
+        switch (char e = *_pos++) {
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'n': out += '\n'; break;
+        case 'r': out += '\r'; break;
+        case 't': out += '\t'; break;
+        case 'u': append_utf8(out, hex4()); break;
+        default: out += e; break;
+        }
+      }
+
+      if (_pos >= _end)
+        fail("unterminated string");
+      ++_pos;
+      return out;
+    }
+
+    uint32_t hex4() {
+      if (_end - _pos < 4)
+        fail("short unicode escape");
+      uint32_t code = std::stoul(std::string(_pos, 4), nullptr, 16);
+      _pos += 4;
+      return code;
+    }
+
+    void append_utf8(std::string& out, uint32_t code) {
+      // Surrogate pairs encode characters outside the basic plane
+      if (code >= 0xd800 && code < 0xdc00 && _end - _pos >= 6 && _pos[0] == '\\' && _pos[1] == 'u') {
+        _pos += 2;
+        code = 0x10000 + ((code - 0xd800) << 10) + (hex4() - 0xdc00);
+      }
+
+      if (code < 0x80) {
+        out += char(code);
+      } else if (code < 0x800) {
+        out += char(0xc0 | code >> 6);
+        out += char(0x80 | (code & 0x3f));
+      } else if (code < 0x10000) {
+        out += char(0xe0 | code >> 12);
+        out += char(0x80 | (code >> 6 & 0x3f));
+        out += char(0x80 | (code & 0x3f));
+      } else {
+        out += char(0xf0 | code >> 18);
+        out += char(0x80 | (code >> 12 & 0x3f));
+        out += char(0x80 | (code >> 6 & 0x3f));
+        out += char(0x80 | (code & 0x3f));
+      }
+    }
+
+    const char* _pos;
+    const char* _end;
+    bool _in_array = false;
+  };
+
+}} // namespace eosio::native
@@ -0,0 +1,636 @@
+#include "chain.hpp"
+#include "abi.hpp"
+#include "records.hpp"
+#include "../bespiral.community/bespiral.community.hpp"
+#include "../utils/utils.hpp"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <netinet/in.h>
+#include <set>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+/**
+   In-memory read model of the BeSpiral contracts, for queries their indexes can't answer.
+
+   Recorded actions are run by the contracts on the native chain, the same way `replay` does,
+   and after every committed transaction the rows it changed update hash and ordered indexes
+   kept next to the chain: sales by word of their title and description, open claims by the
+   validators that still have to vote on them and every executed action, inline ones included,
+   by the accounts it names. Failed transactions change nothing.
+
+   Actions come from trace files, in any format `replay` reads, and then from a TCP feed on
+   `--listen port`, which takes length prefixed records in the binary trace format, one feed at
+   a time. `--send port` is the feed side: it streams trace files to a read model, optionally
+   throttled to `--rate` actions per second, standing in for a trace source.
+
+   Queries are read from stdin, one per line, and answered with one JSON line each:
+
+     sales <cursor> <limit> <word>...     sales with every word, by id
+     pending <cursor> <limit> <account>   unverified claims the account can still vote on, by id
+     history <cursor> <limit> <account>   actions naming the account, in execution order
+     stats                                number of actions applied and rows indexed
+
+   Results start after `cursor`, 0 for the first page, and `next` is the cursor of the next page,
+   or null after the last one.
+
+   Usage: readmodel [--community lib] [--token lib] [--abi code=file] [--state snapshot]
+                    [--listen port] trace...
+          readmodel --send port [--rate actions] trace...
+*/
+
+using eosio::name;
+using eosio::native::abi_def;
+using eosio::native::chain;
+using eosio::native::load_abi;
+using eosio::native::load_records;
+using eosio::native::read_file;
+using eosio::native::record;
+using eosio::native::row_decoder;
+
+namespace {
+
+  const uint64_t max_page_size = 1000;
+  const name community_account{"bes.cmm"};
+
+  void append_json_string(std::string& out, const std::string& str) {
+    out += '"';
+    for (char c : str) {
+      if (c == '"' || c == '\\') { out += '\\'; out += c; }
+      else if (c == '\n') out += "\\n";
+      else if (c == '\r') out += "\\r";
+      else if (c == '\t') out += "\\t";
+      else if ((unsigned char)c < 0x20) {
+        char escaped[8];
+        std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+        out += escaped;
+      }
+      else out += c;
+    }
+    out += '"';
+  }
+
+  // Lower case runs of letters and digits, bytes of multibyte characters count as letters
+  std::set<std::string> words(const std::string& text) {
+    std::set<std::string> result;
+    std::string word;
+    for (char c : text) {
+      unsigned char u = c;
+      if (std::isalnum(u) || u >= 0x80) {
+        word += char(std::tolower(u));
+      } else if (!word.empty()) {
+        result.insert(word);
+        word.clear();
+      }
+    }
+    if (!word.empty())
+      result.insert(word);
+    return result;
+  }
+
+  struct sale_view {
+    name creator;
+    eosio::asset quantity;
+    uint64_t units;
+    std::string title;
+    std::string description;
+    std::set<std::string> words;
+  };
+
+  struct claim_view {
+    uint64_t action_id;
+    name claimer;
+    bool is_verified;
+  };
+
+  struct history_entry {
+    uint64_t seq;
+    uint32_t block_time;
+    name account;
+    name action;
+    std::string data;
+  };
+
+  class read_model {
+  public:
+    explicit read_model(std::map<std::string, abi_def> abis) : _abis(std::move(abis)) {}
+
+    // Brings the indexes in line with the current row, the mirrors hold what was indexed before
+    void apply_change(const chain& c, const chain::row_change& change) {
+      if (name{change.code} != community_account)
+        return;
+
+      const auto* data = c.get_row(name{change.code}, change.scope, name{change.table}, change.primary);
+      name table{change.table};
+      _rows_changed++;
+
+      if (table == name{"sale"}) {
+        remove_sale(change.primary);
+        if (data) add_sale(change.primary, eosio::unpack<bespiral::sale>(*data));
+      } else if (table == name{"blobs"}) {
+        if (data) _blobs[change.primary] = eosio::unpack<bespiral::blob>(*data).data;
+        else _blobs.erase(change.primary);
+      } else if (table == name{"validator"}) {
+        remove_validator(change.scope, change.primary);
+        if (data) add_validator(change.scope, change.primary, eosio::unpack<bespiral::action_validator>(*data));
+      } else if (table == name{"claim"}) {
+        remove_claim(change.primary);
+        if (data) add_claim(change.primary, eosio::unpack<bespiral::claim>(*data));
+      } else if (table == name{"check"}) {
+        remove_check(change.primary);
+        if (data) add_check(change.primary, eosio::unpack<bespiral::check>(*data));
+      }
+    }
+
+    void add_history(uint32_t block_time, const eosio::action& act) {
+      history_entry entry{ ++_seq, block_time, act.account, act.name, {} };
+
+      std::vector<name> names;
+      for (const auto& auth : act.authorization)
+        names.push_back(auth.actor);
+
+      // Actions without an ABI are kept with null data, under their authorizers only
+      entry.data = "null";
+      auto abi = _abis.find(act.account.to_string());
+      if (abi != _abis.end() && abi->second.actions.count(act.name.to_string())) {
+        std::string data;
+        row_decoder reader(act.data.data(), act.data.data() + act.data.size(), &names);
+        try {
+          reader.value(abi->second.compile(abi->second.actions.at(act.name.to_string())), data, true);
+          entry.data = std::move(data);
+        } catch (const std::exception&) {
+        }
+      }
+
+      std::sort(names.begin(), names.end());
+      names.erase(std::unique(names.begin(), names.end()), names.end());
+      for (auto n : names)
+        _history_by_account[n.value].push_back(entry.seq);
+      _history.emplace(entry.seq, std::move(entry));
+    }
+
+    std::string sales(uint64_t cursor, uint64_t limit, const std::vector<std::string>& query) const {
+      std::set<std::string> wanted;
+      for (const auto& q : query)
+        for (const auto& w : words(q))
+          wanted.insert(w);
+
+      // Walk the rarest word, check the others on the sale
+      const std::set<uint64_t>* smallest = nullptr;
+      for (const auto& w : wanted) {
+        auto found = _sales_by_word.find(w);
+        if (found == _sales_by_word.end())
+          return page({}, false, 0);
+        if (!smallest || found->second.size() < smallest->size())
+          smallest = &found->second;
+      }
+
+      std::vector<std::string> items;
+      bool more = false;
+      uint64_t last = 0;
+      if (smallest) {
+        for (auto itr = smallest->upper_bound(cursor); itr != smallest->end(); ++itr) {
+          const auto& sale = _sales.at(*itr);
+          bool all = true;
+          for (const auto& w : wanted)
+            all = all && sale.words.count(w);
+          if (!all) continue;
+          if (items.size() == limit) { more = true; break; }
+
+          std::string item = "{\"id\":" + std::to_string(*itr) + ",\"creator\":\"" + sale.creator.to_string() +
+                             "\",\"quantity\":\"" + sale.quantity.to_string() + "\",\"units\":" +
+                             std::to_string(sale.units) + ",\"title\":";
+          append_json_string(item, sale.title);
+          item += ",\"description\":";
+          append_json_string(item, sale.description);
+          item += "}";
+          items.push_back(std::move(item));
+          last = *itr;
+        }
+      }
+      return page(items, more, last);
+    }
+
+    std::string pending(uint64_t cursor, uint64_t limit, name validator) const {
+      std::vector<std::string> items;
+      bool more = false;
+      uint64_t last = 0;
+
+      auto actions = _actions_by_validator.find(validator.value);
+      if (actions != _actions_by_validator.end()) {
+        // Merge the open claims of each action in id order
+        std::map<uint64_t, uint64_t> next; // Claim id to action id
+        auto advance = [&](uint64_t action_id, uint64_t after) {
+          auto open = _open_claims.find(action_id);
+          if (open == _open_claims.end()) return;
+          auto itr = open->second.upper_bound(after);
+          if (itr != open->second.end()) next.emplace(*itr, action_id);
+        };
+        for (const auto& a : actions->second)
+          advance(a.first, cursor);
+
+        auto voted = _checked_by_validator.find(validator.value);
+        while (!next.empty()) {
+          auto head = *next.begin();
+          next.erase(next.begin());
+          advance(head.second, head.first);
+
+          if (voted != _checked_by_validator.end() && voted->second.count(head.first)) continue;
+          if (items.size() == limit) { more = true; break; }
+
+          const auto& claim = _claims.at(head.first);
+          items.push_back("{\"id\":" + std::to_string(head.first) + ",\"action_id\":" + std::to_string(claim.action_id) +
+                          ",\"claimer\":\"" + claim.claimer.to_string() + "\"}");
+          last = head.first;
+        }
+      }
+      return page(items, more, last);
+    }
+
+    std::string history(uint64_t cursor, uint64_t limit, name account) const {
+      std::vector<std::string> items;
+      bool more = false;
+      uint64_t last = 0;
+
+      auto found = _history_by_account.find(account.value);
+      if (found != _history_by_account.end()) {
+        const auto& seqs = found->second;
+        for (auto itr = std::upper_bound(seqs.begin(), seqs.end(), cursor); itr != seqs.end(); ++itr) {
+          if (items.size() == limit) { more = true; break; }
+          const auto& entry = _history.at(*itr);
+          items.push_back("{\"seq\":" + std::to_string(entry.seq) + ",\"block_time\":" + std::to_string(entry.block_time) +
+                          ",\"account\":\"" + entry.account.to_string() + "\",\"name\":\"" + entry.action.to_string() +
+                          "\",\"data\":" + entry.data + "}");
+          last = entry.seq;
+        }
+      }
+      return page(items, more, last);
+    }
+
+    std::string stats(uint64_t applied, uint64_t failed) const {
+      return "{\"applied\":" + std::to_string(applied) + ",\"failed\":" + std::to_string(failed) +
+             ",\"rows_changed\":" + std::to_string(_rows_changed) + ",\"sales\":" + std::to_string(_sales.size()) +
+             ",\"words\":" + std::to_string(_sales_by_word.size()) + ",\"claims\":" + std::to_string(_claims.size()) +
+             ",\"history\":" + std::to_string(_history.size()) + "}";
+    }
+
+  private:
+    static std::string page(const std::vector<std::string>& items, bool more, uint64_t last) {
+      std::string out = "{\"items\":[";
+      for (size_t i = 0; i < items.size(); i++) {
+        if (i > 0) out += ',';
+        out += items[i];
+      }
+      out += "],\"next\":";
+      out += more ? std::to_string(last) : "null";
+      out += '}';
+      return out;
+    }
+
+    std::string text(const std::string& field, const eosio::binary_extension<uint64_t>& handle) const {
+      if (handle.value_or(0) == 0) return field;
+      auto blob = _blobs.find(handle.value());
+      return blob == _blobs.end() ? field : blob->second;
+    }
+
+    void add_sale(uint64_t id, const bespiral::sale& s) {
+      auto& view = _sales[id];
+      view = { s.creator, s.quantity, s.units, s.title, text(s.description, s.description_handle), {} };
+      view.words = words(view.title + " " + view.description);
+      for (const auto& w : view.words)
+        _sales_by_word[w].insert(id);
+    }
+
+    void remove_sale(uint64_t id) {
+      auto found = _sales.find(id);
+      if (found == _sales.end()) return;
+      for (const auto& w : found->second.words) {
+        auto& ids = _sales_by_word[w];
+        ids.erase(id);
+        if (ids.empty()) _sales_by_word.erase(w);
+      }
+      _sales.erase(found);
+    }
+
+    void add_validator(uint64_t scope, uint64_t id, const bespiral::action_validator& v) {
+      _validators[{ scope, id }] = { v.action_id, v.validator };
+      _actions_by_validator[v.validator.value][v.action_id]++;
+    }
+
+    void remove_validator(uint64_t scope, uint64_t id) {
+      auto found = _validators.find({ scope, id });
+      if (found == _validators.end()) return;
+      auto& actions = _actions_by_validator[found->second.second.value];
+      if (--actions[found->second.first] == 0) actions.erase(found->second.first);
+      _validators.erase(found);
+    }
+
+    void add_claim(uint64_t id, const bespiral::claim& c) {
+      _claims[id] = { c.action_id, c.claimer, c.is_verified == 1 };
+      if (c.is_open()) _open_claims[c.action_id].insert(id);
+    }
+
+    void remove_claim(uint64_t id) {
+      auto found = _claims.find(id);
+      if (found == _claims.end()) return;
+      _open_claims[found->second.action_id].erase(id);
+      _claims.erase(found);
+    }
+
+    void add_check(uint64_t id, const bespiral::check& c) {
+      _checks[id] = { c.claim_id, c.validator };
+      _checked_by_validator[c.validator.value].insert(c.claim_id);
+    }
+
+    void remove_check(uint64_t id) {
+      auto found = _checks.find(id);
+      if (found == _checks.end()) return;
+      _checked_by_validator[found->second.second.value].erase(found->second.first);
+      _checks.erase(found);
+    }
+
+    std::map<std::string, abi_def> _abis;
+
+    std::map<uint64_t, sale_view> _sales;
+    std::unordered_map<std::string, std::set<uint64_t>> _sales_by_word;
+    std::unordered_map<uint64_t, std::string> _blobs;
+
+    std::map<std::pair<uint64_t, uint64_t>, std::pair<uint64_t, name>> _validators; // (scope, id) to (action, validator)
+    std::unordered_map<uint64_t, std::map<uint64_t, uint32_t>> _actions_by_validator; // Action ids with their row count
+    std::unordered_map<uint64_t, claim_view> _claims;
+    std::unordered_map<uint64_t, std::set<uint64_t>> _open_claims; // By action id
+    std::unordered_map<uint64_t, std::pair<uint64_t, name>> _checks; // Id to (claim, validator)
+    std::unordered_map<uint64_t, std::set<uint64_t>> _checked_by_validator;
+
+    std::map<uint64_t, history_entry> _history;
+    std::unordered_map<uint64_t, std::vector<uint64_t>> _history_by_account;
+    uint64_t _seq = 0;
+
+    uint64_t _rows_changed = 0;
+  };
+
+  // Runs actions on the chain and feeds what they did to the read model
+  class service {
+  public:
+    service(chain& c, read_model& model) : _chain(c), _model(model) {}
+
+    void load_state(const chain::snapshot& state) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      for (const auto& t : state.tables)
+        for (const auto& r : t.second)
+          _model.apply_change(_chain, { t.first.code, t.first.scope, t.first.table, r.first });
+    }
+
+    void apply(const record& r) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (r.block_time > _chain.time()) {
+        _chain.set_time(r.block_time);
+        _chain.run_deferred();
+      }
+
+      try {
+        _chain.push_transaction({ r.act });
+        _applied++;
+        for (const auto& act : _chain.executed())
+          _model.add_history(r.block_time, act);
+      } catch (const std::exception& e) {
+        if (_failed++ < 10)
+          std::fprintf(stderr, "  %s::%s failed: %s\n", r.act.account.to_string().c_str(), r.act.name.to_string().c_str(), e.what());
+      }
+
+      for (const auto& change : _chain.take_changes())
+        _model.apply_change(_chain, change);
+    }
+
+    std::string query(const std::string& line) {
+      std::istringstream in(line);
+      std::string kind;
+      uint64_t cursor = 0, limit = 0;
+      in >> kind;
+
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (kind == "stats")
+        return _model.stats(_applied, _failed);
+      if (kind != "sales" && kind != "pending" && kind != "history")
+        return error("unknown query, expected sales, pending, history or stats");
+
+      if (!(in >> cursor >> limit) || limit == 0 || limit > max_page_size)
+        return error("expected <cursor> <limit> after the query, with a limit from 1 to " + std::to_string(max_page_size));
+
+      std::vector<std::string> args;
+      for (std::string arg; in >> arg;)
+        args.push_back(arg);
+
+      if (kind == "sales" && !args.empty())
+        return _model.sales(cursor, limit, args);
+      if ((kind == "pending" || kind == "history") && args.size() == 1) {
+        if (!is_valid_name(args[0]))
+          return error("invalid account name " + args[0]);
+        name account{args[0]};
+        return kind == "pending" ? _model.pending(cursor, limit, account) : _model.history(cursor, limit, account);
+      }
+      return error(kind == "sales" ? "expected the words to look for" : "expected an account name");
+    }
+
+    uint64_t applied() const { return _applied; }
+    uint64_t failed() const { return _failed; }
+
+  private:
+    static std::string error(const std::string& message) {
+      std::string out = "{\"error\":";
+      append_json_string(out, message);
+      return out + "}";
+    }
+
+    chain& _chain;
+    read_model& _model;
+    std::mutex _mutex;
+    uint64_t _applied = 0;
+    uint64_t _failed = 0;
+  };
+
+  bool read_exact(int fd, char* data, size_t size) {
+    while (size > 0) {
+      ssize_t n = ::read(fd, data, size);
+      if (n <= 0) return false;
+      data += n;
+      size -= n;
+    }
+    return true;
+  }
+
+  bool write_exact(int fd, const char* data, size_t size) {
+    while (size > 0) {
+      ssize_t n = ::write(fd, data, size);
+      if (n <= 0) return false;
+      data += n;
+      size -= n;
+    }
+    return true;
+  }
+
+  // Accepts feeds one after another, each a sequence of (uint32 size, packed record)
+  void serve_feed(service& s, uint16_t port) {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    int yes = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listener, 1) != 0) {
+      std::fprintf(stderr, "unable to listen on port %u\n", port);
+      return;
+    }
+
+    while (true) {
+      int fd = accept(listener, nullptr, nullptr);
+      if (fd < 0) continue;
+
+      std::vector<char> data;
+      uint32_t size;
+      while (read_exact(fd, reinterpret_cast<char*>(&size), sizeof(size))) {
+        data.resize(size);
+        if (!read_exact(fd, data.data(), size)) break;
+
+        record r;
+        try {
+          eosio::datastream<const char*> ds(data.data(), data.size());
+          ds >> r.block_time >> r.act;
+        } catch (const std::exception& e) {
+          std::fprintf(stderr, "dropping feed: %s\n", e.what());
+          break;
+        }
+        s.apply(r);
+      }
+      close(fd);
+    }
+  }
+
+  int send_feed(uint16_t port, uint64_t rate, const std::vector<record>& records) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+      std::fprintf(stderr, "unable to connect to port %u\n", port);
+      return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < records.size(); i++) {
+      if (rate > 0)
+        std::this_thread::sleep_until(start + std::chrono::microseconds(i * 1000000 / rate));
+
+      auto bytes = eosio::pack(std::make_tuple(records[i].block_time, records[i].act));
+      uint32_t size = bytes.size();
+      if (!write_exact(fd, reinterpret_cast<const char*>(&size), sizeof(size)) || !write_exact(fd, bytes.data(), size)) {
+        std::fprintf(stderr, "feed closed after %zu actions\n", i);
+        return 1;
+      }
+    }
+    close(fd);
+    std::printf("sent %zu actions\n", records.size());
+    return 0;
+  }
+
+}
+
+int main(int argc, char** argv) {
+  std::string community_lib = "./bespiral.community.so";
+  std::string token_lib = "./bespiral.token.so";
+  std::map<std::string, std::string> abi_paths = {
+    { "bes.cmm", "../bespiral.community/bespiral.community.abi" },
+    { "bes.token", "../bespiral.token/bespiral.token.abi" }
+  };
+  std::string state_path;
+  uint16_t listen_port = 0, send_port = 0;
+  uint64_t rate = 0;
+  std::vector<std::string> traces;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "--community" && has_value) community_lib = argv[++i];
+    else if (arg == "--token" && has_value) token_lib = argv[++i];
+    else if (arg == "--abi" && has_value) {
+      std::string value = argv[++i];
+      auto eq = value.find('=');
+      if (eq == std::string::npos) {
+        std::fprintf(stderr, "--abi takes code=file\n");
+        return 1;
+      }
+      abi_paths[value.substr(0, eq)] = value.substr(eq + 1);
+    }
+    else if (arg == "--state" && has_value) state_path = argv[++i];
+    else if (arg == "--listen" && has_value) listen_port = std::stoul(argv[++i]);
+    else if (arg == "--send" && has_value) send_port = std::stoul(argv[++i]);
+    else if (arg == "--rate" && has_value) rate = std::stoull(argv[++i]);
+    else if (arg.compare(0, 2, "--") == 0) {
+      std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+      return 1;
+    }
+    else traces.push_back(arg);
+  }
+
+  try {
+    std::vector<record> records;
+    for (const auto& path : traces)
+      load_records(path, records);
+
+    if (send_port != 0)
+      return send_feed(send_port, rate, records);
+
+    std::map<std::string, abi_def> abis;
+    for (const auto& a : abi_paths)
+      abis.emplace(a.first, load_abi(read_file(a.second)));
+
+    chain c;
+    c.accept_any_account(true);
+    c.deploy(name{"bes.cmm"}, community_lib);
+    c.deploy(name{"bes.token"}, token_lib);
+
+    read_model model(std::move(abis));
+    service s(c, model);
+
+    if (!state_path.empty()) {
+      std::ifstream in(state_path, std::ios::binary);
+      c.restore_snapshot(chain::snapshot::load(in));
+      s.load_state(c.take_snapshot());
+    }
+    c.track_changes(true);
+
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& r : records)
+      s.apply(r);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::fprintf(stderr, "applied %zu actions in %.3f s, %llu failed\n", records.size(), seconds,
+                 (unsigned long long)s.failed());
+
+    if (listen_port != 0)
+      std::thread(serve_feed, std::ref(s), listen_port).detach();
+
+    for (std::string line; std::getline(std::cin, line);) {
+      if (line.empty()) continue;
+      std::cout << s.query(line) << std::endl;
+    }
+    return 0;
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "readmodel failed: %s\n", e.what());
+    return 1;
+  }
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "json.hpp"
+
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/action.hpp>
+
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace eosio { namespace native {
+
+  /**
+     Recorded BeSpiral actions, read from traces exported by a history node or from the binary
+     format the tools write.
+
+     JSON traces hold one action per entry, in an array or one per line. Only top level actions
+     are kept, inline actions and notifications are skipped since the contracts emit them again.
+     The binary format is a sequence of block time plus packed action records.
+  */
+  struct record {
+    uint32_t block_time = 0;
+    eosio::action act;
+  };
+
+  inline std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+      throw std::runtime_error("unable to open " + path);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+
+  inline bool ends_with(const std::string& str, const std::string& suffix) {
+    return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+  }
+
+  // "2019-05-01T12:00:00.000", fractions and time zone suffixes are ignored
+  inline uint32_t parse_time(const std::string& str) {
+    std::tm tm = {};
+    if (sscanf(str.c_str(), "%d-%d-%dT%d:%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+               &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 6)
+      throw std::runtime_error("invalid block_time " + str);
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    return timegm(&tm);
+  }
+
+  inline std::vector<char> parse_hex(const std::string& hex) {
+    if (hex.size() % 2 != 0)
+      throw std::runtime_error("invalid hex_data");
+    std::vector<char> data(hex.size() / 2);
+    for (size_t i = 0; i < data.size(); i++)
+      data[i] = std::stoi(hex.substr(i * 2, 2), nullptr, 16);
+    return data;
+  }
+
+  // Accepts plain actions as well as the action traces of the history API
+  inline bool to_record(const json& entry, record& out) {
+    const json* trace = entry.find("action_trace") ? entry.find("action_trace") : &entry;
+    const json* act = trace->find("act") ? trace->find("act") : trace;
+
+    if (!act->find("account") || !act->find("name"))
+      throw std::runtime_error("trace entry without account or name");
+    out.act.account = name{act->find("account")->as_string()};
+    out.act.name = name{act->find("name")->as_string()};
+
+    const json* receipt = trace->find("receipt");
+    const json* receiver = receipt ? receipt->find("receiver") : trace->find("receiver");
+    if (receiver && name{receiver->as_string()} != out.act.account)
+      return false;
+
+    const json* creator = trace->find("creator_action_ordinal");
+    if (creator && creator->as_string() != "0")
+      return false;
+
+    out.act.authorization.clear();
+    if (const json* auths = act->find("authorization")) {
+      for (const auto& auth : auths->items)
+        out.act.authorization.push_back({ name{auth.find("actor")->as_string()},
+                                          name{auth.find("permission")->as_string()} });
+    }
+
+    const json* hex = act->find("hex_data");
+    if (!hex && act->find("data") && act->find("data")->kind == json::string)
+      hex = act->find("data");
+    if (!hex)
+      throw std::runtime_error("trace entry without hex_data for " + out.act.name.to_string());
+    out.act.data = parse_hex(hex->as_string());
+
+    const json* time = entry.find("block_time") ? entry.find("block_time") : trace->find("block_time");
+    out.block_time = time ? parse_time(time->as_string()) : 0;
+    return true;
+  }
+
+  inline void load_json(const std::string& content, std::vector<record>& records) {
+    json_reader reader(content.data(), content.data() + content.size());
+    record r;
+
+    if (reader.enter_array()) {
+      while (reader.more_in_array()) {
+        if (to_record(reader.next(), r))
+          records.push_back(r);
+      }
+      return;
+    }
+
+    while (reader.more()) {
+      if (to_record(reader.next(), r))
+        records.push_back(r);
+    }
+  }
+
+  inline void load_binary(const std::string& content, std::vector<record>& records) {
+    eosio::datastream<const char*> ds(content.data(), content.size());
+    while (ds.remaining()) {
+      record r;
+      ds >> r.block_time >> r.act;
+      records.push_back(std::move(r));
+    }
+  }
+
+  inline void save_binary(const std::string& path, const std::vector<record>& records) {
+    std::ofstream out(path, std::ios::binary);
+    for (const auto& r : records) {
+      auto bytes = eosio::pack(std::make_tuple(r.block_time, r.act));
+      out.write(bytes.data(), bytes.size());
+    }
+  }
+
+  inline void load_records(const std::string& path, std::vector<record>& records) {
+    auto content = read_file(path);
+    if (ends_with(path, ".bin"))
+      load_binary(content, records);
+    else
+      load_json(content, records);
+  }
+
+}} // namespace eosio::native
@@ -0,0 +1,223 @@
+#include "chain.hpp"
+#include "records.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+   Replays recorded BeSpiral actions against the contracts on the native chain.
+
+   Traces are either JSON, as exported by a history node (one action per entry, in an array or
+   one per line), or the binary format written by `--convert`: a sequence of block time plus
+   packed action records. Only top level actions are replayed, inline actions and notifications
+   found in the trace are skipped since the contracts emit them again.
+
+   Reports throughput, latency percentiles per action and table sizes, and optionally compares
+   the final state with a snapshot saved by an earlier run.
+
+   Usage: replay [--community lib] [--token lib] [--state snapshot] [--save snapshot]
+                 [--reference snapshot] [--convert file] trace...
+*/
+
+using eosio::name;
+using eosio::native::chain;
+using eosio::native::load_records;
+using eosio::native::record;
+using eosio::native::save_binary;
+
+namespace {
+
+  double percentile(const std::vector<double>& sorted, double p) {
+    return sorted[std::min(sorted.size() - 1, size_t(p * sorted.size()))];
+  }
+
+  struct table_diff {
+    uint64_t added = 0;
+    uint64_t missing = 0;
+    uint64_t changed = 0;
+  };
+
+  // Compares rows only, secondary indexes follow from them
+  bool diff(const chain::snapshot& state, const chain::snapshot& reference) {
+    std::map<std::pair<name, name>, table_diff> diffs;
+    std::vector<std::string> examples;
+
+    auto note = [&](const chain::table_key& key, uint64_t primary, const char* what) {
+      if (examples.size() < 10) {
+        examples.push_back(name{key.code}.to_string() + " " + name{key.table}.to_string() + " scope " +
+                           std::to_string(key.scope) + " id " + std::to_string(primary) + ": " + what);
+      }
+    };
+
+    static const chain::rows empty;
+    std::set<chain::table_key> keys;
+    for (const auto& t : state.tables) keys.insert(t.first);
+    for (const auto& t : reference.tables) keys.insert(t.first);
+
+    for (const auto& key : keys) {
+      auto ours = state.tables.count(key) ? &state.tables.at(key) : &empty;
+      auto theirs = reference.tables.count(key) ? &reference.tables.at(key) : &empty;
+      auto& d = diffs[{ name{key.code}, name{key.table} }];
+
+      for (const auto& r : *ours) {
+        auto other = theirs->find(r.first);
+        if (other == theirs->end()) {
+          d.added++;
+          note(key, r.first, "not in the reference");
+        } else if (other->second.data != r.second.data) {
+          d.changed++;
+          note(key, r.first, "differs from the reference");
+        }
+      }
+
+      for (const auto& r : *theirs) {
+        if (ours->count(r.first) == 0) {
+          d.missing++;
+          note(key, r.first, "missing");
+        }
+      }
+    }
+
+    bool equal = true;
+    std::printf("\nstate diff against the reference\n%-12s %-12s %10s %10s %10s\n", "code", "table", "added", "missing", "changed");
+    for (const auto& d : diffs) {
+      if (d.second.added + d.second.missing + d.second.changed == 0)
+        continue;
+      equal = false;
+      std::printf("%-12s %-12s %10llu %10llu %10llu\n", d.first.first.to_string().c_str(), d.first.second.to_string().c_str(),
+                  (unsigned long long)d.second.added, (unsigned long long)d.second.missing,
+                  (unsigned long long)d.second.changed);
+    }
+
+    for (const auto& example : examples)
+      std::printf("  %s\n", example.c_str());
+    if (equal)
+      std::printf("identical\n");
+    return equal;
+  }
+
+}
+
+int main(int argc, char** argv) {
+  std::string community_lib = "./bespiral.community.so";
+  std::string token_lib = "./bespiral.token.so";
+  std::string state_path, save_path, reference_path, convert_path;
+  std::vector<std::string> traces;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "--community" && has_value) community_lib = argv[++i];
+    else if (arg == "--token" && has_value) token_lib = argv[++i];
+    else if (arg == "--state" && has_value) state_path = argv[++i];
+    else if (arg == "--save" && has_value) save_path = argv[++i];
+    else if (arg == "--reference" && has_value) reference_path = argv[++i];
+    else if (arg == "--convert" && has_value) convert_path = argv[++i];
+    else if (arg.compare(0, 2, "--") == 0) {
+      std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+      return 1;
+    }
+    else traces.push_back(arg);
+  }
+
+  if (traces.empty()) {
+    std::fprintf(stderr, "usage: replay [--community lib] [--token lib] [--state snapshot] [--save snapshot] "
+                         "[--reference snapshot] [--convert file] trace...\n");
+    return 1;
+  }
+
+  try {
+    std::vector<record> records;
+    for (const auto& path : traces) {
+      load_records(path, records);
+    }
+
+    if (!convert_path.empty()) {
+      save_binary(convert_path, records);
+      std::printf("wrote %zu actions to %s\n", records.size(), convert_path.c_str());
+      return 0;
+    }
+
+    chain c;
+    c.accept_any_account(true);
+    c.deploy(name{"bes.cmm"}, community_lib);
+    c.deploy(name{"bes.token"}, token_lib);
+
+    if (!state_path.empty()) {
+      std::ifstream in(state_path, std::ios::binary);
+      c.restore_snapshot(chain::snapshot::load(in));
+    }
+
+    std::map<name, std::vector<double>> latencies;
+    std::vector<std::string> failures;
+    uint64_t failed = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < records.size(); i++) {
+      const auto& r = records[i];
+      if (r.block_time > c.time()) {
+        c.set_time(r.block_time);
+        c.run_deferred();
+      }
+
+      auto action_start = std::chrono::steady_clock::now();
+      try {
+        c.push_transaction({ r.act });
+      } catch (const std::exception& e) {
+        failed++;
+        if (failures.size() < 10)
+          failures.push_back("#" + std::to_string(i) + " " + r.act.account.to_string() + "::" +
+                             r.act.name.to_string() + ": " + e.what());
+      }
+      latencies[r.act.name].push_back(
+        std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - action_start).count());
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("replayed %zu actions in %.3f s, %.0f actions/s, %llu failed\n",
+                records.size(), seconds, records.size() / std::max(seconds, 1e-9), (unsigned long long)failed);
+    for (const auto& failure : failures)
+      std::printf("  %s\n", failure.c_str());
+
+    std::printf("\n%-13s %10s %10s %10s %10s %10s\n", "action", "count", "p50 us", "p90 us", "p99 us", "max us");
+    for (auto& l : latencies) {
+      std::sort(l.second.begin(), l.second.end());
+      std::printf("%-13s %10zu %10.2f %10.2f %10.2f %10.2f\n", l.first.to_string().c_str(), l.second.size(),
+                  percentile(l.second, 0.5), percentile(l.second, 0.9), percentile(l.second, 0.99), l.second.back());
+    }
+
+    auto state = c.take_snapshot();
+    std::map<std::pair<name, name>, size_t> sizes;
+    for (const auto& t : state.tables)
+      sizes[{ name{t.first.code}, name{t.first.table} }] += t.second.size();
+
+    std::printf("\n%-12s %-12s %10s\n", "code", "table", "rows");
+    for (const auto& s : sizes)
+      std::printf("%-12s %-12s %10zu\n", s.first.first.to_string().c_str(), s.first.second.to_string().c_str(), s.second);
+
+    if (!save_path.empty()) {
+      std::ofstream out(save_path, std::ios::binary);
+      state.save(out);
+    }
+
+    bool equal = true;
+    if (!reference_path.empty()) {
+      std::ifstream in(reference_path, std::ios::binary);
+      equal = diff(state, chain::snapshot::load(in));
+    }
+
+    return failed == 0 && equal ? 0 : 2;
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "replay failed: %s\n", e.what());
+    return 1;
+  }
+}
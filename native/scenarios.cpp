@@ -0,0 +1,885 @@
+#include "chain.hpp"
+#include "../bespiral.community/bespiral.community.hpp"
+#include "../utils/utils.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+   Scenario checks of the contracts on the native chain.
+
+   Each scenario starts from a fresh chain with one `mcc` community, pushes the actions of a
+   user story and checks the rows they leave. Prints one line per scenario and the failed
+   checks below it, and exits non-zero when any of them fails. Run with `make check`.
+
+   Usage: scenarios [name...]
+*/
+
+using eosio::asset;
+using eosio::name;
+using eosio::symbol;
+using eosio::native::chain;
+
+namespace {
+
+  const name community_contract{"bes.cmm"};
+  const name token_contract{"bes.token"};
+  const name founder{"founder"};
+
+  const symbol community_symbol{"BES", 4};
+
+  // Data of the token `issue` action
+  struct issue_data {
+    name to;
+    asset quantity;
+    std::string memo;
+  };
+
+  // Row of the token `checkpoints` table
+  struct checkpoint_row {
+    uint64_t id;
+    name owner;
+    uint64_t epoch;
+    asset balance;
+  };
+
+  // Row of the token `daily` table
+  struct daily_bucket {
+    uint32_t day;
+    uint64_t transfers;
+    asset transfer_volume;
+    asset issued;
+    asset retired;
+  };
+
+  // Row of the token `recent` table
+  struct recent_ring {
+    eosio::symbol_code currency;
+    uint8_t next;
+    struct entry {
+      name counterparty;
+      int64_t amount;
+      uint32_t time;
+      uint32_t memo_hash;
+    };
+    std::vector<entry> transfers;
+  };
+
+  // Data of the inline `rowspage` action sent by `exportrows`
+  struct rows_page {
+    name table;
+    uint64_t scope;
+    uint64_t next_id;
+    bulk::packed_rows rows;
+  };
+
+  class scenario {
+  public:
+    explicit scenario(std::vector<std::string>& failures) : _failures(failures) {
+      _chain.set_time(1546300800);
+      _chain.create_account(founder);
+      _chain.deploy(community_contract, "./bespiral.community.so");
+      _chain.deploy(token_contract, "./bespiral.token.so");
+
+      push(community_contract, name{"create"}, founder,
+           asset(0, community_symbol), founder, std::string("logo"), std::string("BeSpiral"),
+           std::string("Scenario community"), asset(0, community_symbol), asset(0, community_symbol));
+      push(token_contract, name{"create"}, founder,
+           founder, asset(1000000000, community_symbol), asset(-100000, community_symbol), std::string("mcc"));
+    }
+
+    void member(name account) {
+      _chain.create_account(account);
+      push(community_contract, name{"netlink"}, founder, asset(0, community_symbol), founder, account);
+    }
+
+    template<typename... Args>
+    void push(name account, name action_name, name actor, Args&&... args) {
+      try {
+        _chain.push(account, action_name, actor, std::forward<Args>(args)...);
+      } catch (const std::exception& e) {
+        fail(action_name.to_string() + " failed: " + e.what());
+      }
+    }
+
+    // Expects the action to abort with a message containing `message`
+    template<typename... Args>
+    void push_fails(const std::string& message, name account, name action_name, name actor, Args&&... args) {
+      try {
+        _chain.push(account, action_name, actor, std::forward<Args>(args)...);
+        fail(action_name.to_string() + " should have failed with \"" + message + "\"");
+      } catch (const eosio::native::assertion_failure& e) {
+        if (std::string(e.what()).find(message) == std::string::npos)
+          fail(action_name.to_string() + " failed with \"" + e.what() + "\" instead of \"" + message + "\"");
+      }
+    }
+
+    void expect(bool condition, const std::string& what) {
+      if (!condition) fail(what);
+    }
+
+    int64_t balance(name owner) const {
+      const auto* row = _chain.get_row(token_contract, owner.value, name{"accounts"}, community_symbol.code().raw());
+      return row ? eosio::unpack<currency_balance>(*row).balance.amount : 0;
+    }
+
+    template<typename T>
+    T row(name table, uint64_t primary, uint64_t scope = community_contract.value) const {
+      return _chain.get_row_as<T>(community_contract, scope, table, primary);
+    }
+
+    bool has_row(name table, uint64_t primary, uint64_t scope = community_contract.value) const {
+      return _chain.get_row(community_contract, scope, table, primary) != nullptr;
+    }
+
+    bespiral::network member_row(name account) const {
+      return row<bespiral::network>(name{"network"}, gen_uuid(community_symbol.raw(), account.value));
+    }
+
+    // Cuts every row of a community table to its first `size` bytes, as written before the
+    // binary extensions that follow existed
+    void make_legacy(name table, size_t size) {
+      auto state = _chain.take_snapshot();
+      for (auto& [key, rows] : state.tables) {
+        if (key.code != community_contract.value || key.table != table.value) continue;
+        for (auto& r : rows)
+          r.second.data.resize(std::min(r.second.data.size(), size));
+      }
+      _chain.restore_snapshot(std::move(state));
+    }
+
+    // Erases every row of a contract table, in every scope
+    void clear_table(name table, name contract = community_contract) {
+      auto state = _chain.take_snapshot();
+      for (auto itr = state.tables.begin(); itr != state.tables.end();) {
+        if (itr->first.code == contract.value && itr->first.table == table.value)
+          itr = state.tables.erase(itr);
+        else
+          itr++;
+      }
+      _chain.restore_snapshot(std::move(state));
+    }
+
+    uint64_t open_claims(name claimer, uint64_t action_id) const {
+      const auto* data = _chain.get_row(community_contract, claimer.value, name{"openclaims"}, action_id);
+      return data ? eosio::unpack<bespiral::open_claim_count>(*data).open : 0;
+    }
+
+    // Queues a maintenance job of a contract and runs it to the end, `max_rows` rows per call.
+    // Both contracts keep their jobs in rows of the same layout
+    bespiral::job run_job(name type, uint64_t argument, uint64_t max_rows, name contract = community_contract) {
+      push(contract, name{"addjob"}, contract, type, argument);
+      const auto* jobs = _chain.find_table(contract.value, contract.value, name{"jobs"}.value);
+      if (jobs == nullptr || jobs->empty()) return {};
+
+      uint64_t id = jobs->rbegin()->first;
+      auto job = [&] { return _chain.get_row_as<bespiral::job>(contract, contract.value, name{"jobs"}, id); };
+      for (int calls = 0; calls < 1000 && !job().is_done; calls++)
+        push(contract, name{"runjob"}, contract, id, max_rows);
+      expect(job().is_done, type.to_string() + " job finishes");
+      return job();
+    }
+
+    chain& native() { return _chain; }
+
+  private:
+    void fail(const std::string& what) { _failures.push_back(what); }
+
+    chain _chain;
+    std::vector<std::string>& _failures;
+  };
+
+  // A claim the validators left can't verify anymore stops counting as open
+  void rejected_claim_is_released(scenario& s) {
+    for (auto account : { name{"bob"}, name{"valone"}, name{"valtwo"}, name{"valthree"} })
+      s.member(account);
+
+    s.push(community_contract, name{"newobjective"}, founder,
+           asset(0, community_symbol), std::string("Objective"), founder);
+    s.push(community_contract, name{"upsertaction"}, founder,
+           uint64_t(0), uint64_t(1), std::string("Action"),
+           asset(10, community_symbol), asset(1, community_symbol), uint64_t(0),
+           uint64_t(0), uint64_t(0), uint64_t(2), std::string("claimable"),
+           std::string("valone-valtwo-valthree"), uint8_t(0), founder, uint64_t(1));
+
+    s.push(community_contract, name{"claimaction"}, name{"bob"}, uint64_t(1), name{"bob"});
+    s.push_fails("limit of open claims", community_contract, name{"claimaction"}, name{"bob"}, uint64_t(1), name{"bob"});
+
+    s.push(community_contract, name{"verifyclaim"}, name{"valone"}, uint64_t(1), name{"valone"}, uint8_t(0));
+    s.expect(s.row<bespiral::claim>(name{"claim"}, 1).is_open(), "a claim that can still be verified stays open");
+
+    s.push(community_contract, name{"verifyclaim"}, name{"valtwo"}, uint64_t(1), name{"valtwo"}, uint8_t(0));
+    auto rejected = s.row<bespiral::claim>(name{"claim"}, 1);
+    s.expect(rejected.was_rejected() && rejected.is_verified == 0, "the claim is rejected after the last no vote and stays unverified");
+    s.expect(s.row<bespiral::aggregate>(name{"aggregates"}, community_symbol.raw()).open_claims == 0,
+             "the rejected claim left the open claims of the aggregates");
+
+    s.push(community_contract, name{"claimaction"}, name{"bob"}, uint64_t(1), name{"bob"});
+    s.expect(s.has_row(name{"claim"}, 2), "the maker can claim again once the first claim is rejected");
+    s.push_fails("rejected", community_contract, name{"verifyclaim"}, name{"valthree"}, uint64_t(1), name{"valthree"}, uint8_t(1));
+  }
+
+  // Buy orders hold units of the seller's tracked sales, nothing is paid until the buyer accepts
+  void buy_order_needs_buyer_approval(scenario& s) {
+    const name bob{"bob"}, carol{"carol"}, mallory{"mallory"};
+    const uint64_t orders = community_symbol.code().raw();
+    for (auto account : { bob, carol, mallory })
+      s.member(account);
+
+    s.push_fails("Can't order from yourself", community_contract, name{"newbuyorder"}, bob,
+                 bob, bob, asset(100, community_symbol), uint64_t(1));
+    s.push(community_contract, name{"newbuyorder"}, bob, bob, carol, asset(100, community_symbol), uint64_t(5));
+
+    // Sales from anyone but the seller of the order, or without tracked stock, are never matched
+    s.push(community_contract, name{"createsale"}, mallory, mallory, std::string("Bait"), std::string(""),
+           asset(100, community_symbol), std::string(""), uint8_t(0), uint64_t(0));
+    s.push(community_contract, name{"createsale"}, carol, carol, std::string("Unlimited"), std::string(""),
+           asset(100, community_symbol), std::string(""), uint8_t(0), uint64_t(0));
+    s.expect(!s.has_row(name{"orderfills"}, 0), "untracked sales and other sellers don't fill the order");
+    s.expect(s.row<bespiral::buy_order>(name{"buyorders"}, 0, orders).units == 5, "the order is untouched");
+
+    int64_t bob_before = s.balance(bob), carol_before = s.balance(carol);
+
+    // A tracked sale of the seller holds units for the order without paying
+    s.push(community_contract, name{"createsale"}, carol, carol, std::string("Bread"), std::string(""),
+           asset(80, community_symbol), std::string(""), uint8_t(1), uint64_t(3));
+    s.expect(s.has_row(name{"orderfills"}, 0), "the seller's tracked sale fills the order");
+    auto fill = s.row<bespiral::order_fill>(name{"orderfills"}, 0);
+    s.expect(fill.buyer == bob && fill.seller == carol && fill.units == 3 && fill.total.amount == 240,
+             "the fill holds every unit of the sale at the sale price");
+    s.expect(s.row<bespiral::sale>(name{"sale"}, 3).units == 0, "the held units left the sale");
+    s.expect(s.row<bespiral::buy_order>(name{"buyorders"}, 0, orders).units == 2, "the order keeps the units left");
+    s.expect(s.balance(bob) == bob_before && s.balance(carol) == carol_before, "nothing is paid before the buyer accepts");
+
+    s.push_fails("missing authority of bob", community_contract, name{"acceptfill"}, carol, uint64_t(0));
+    s.push_fails("missing authority of bob", community_contract, name{"acceptfill"}, mallory, uint64_t(0));
+    s.push(community_contract, name{"acceptfill"}, bob, uint64_t(0));
+    s.expect(s.balance(bob) == bob_before - 240 && s.balance(carol) == carol_before + 240, "accepting pays the seller");
+    s.expect(!s.has_row(name{"orderfills"}, 0), "the paid fill is gone");
+
+    // Restocking holds the rest of the order, and the seller can give it back
+    s.push(community_contract, name{"updatesale"}, carol, uint64_t(3), std::string("Bread"), std::string(""),
+           asset(80, community_symbol), std::string(""), uint8_t(1), uint64_t(10));
+    s.expect(s.row<bespiral::order_fill>(name{"orderfills"}, 0).units == 2, "the restocked sale fills the rest");
+    s.expect(!s.has_row(name{"buyorders"}, 0, orders), "the filled order is gone");
+    s.push_fails("missing authority of bob", community_contract, name{"rejectfill"}, mallory, uint64_t(0));
+    s.push(community_contract, name{"rejectfill"}, carol, uint64_t(0));
+    s.expect(s.row<bespiral::sale>(name{"sale"}, 3).units == 10, "rejecting gives the units back to the sale");
+    s.expect(s.balance(bob) == bob_before - 240, "rejecting pays nothing");
+  }
+
+  // A sale only walks the buy orders of its own community, and an order its buyer can't pay yet
+  // waits for a later sale instead of being dropped
+  void buy_orders_stay_in_their_community(scenario& s) {
+    const name bob{"bob"}, carol{"carol"}, mallory{"mallory"};
+    const symbol other_symbol{"OTH", 4};
+    const uint64_t orders = community_symbol.code().raw(), other_orders = other_symbol.code().raw();
+    for (auto account : { bob, carol, mallory })
+      s.member(account);
+
+    s.push(community_contract, name{"create"}, founder,
+           asset(0, other_symbol), founder, std::string("logo"), std::string("Other"),
+           std::string("Another community of the seller"), asset(0, other_symbol), asset(0, other_symbol));
+    s.push(token_contract, name{"create"}, founder,
+           founder, asset(1000000000, other_symbol), asset(-100000, other_symbol), std::string("mcc"));
+    for (auto account : { bob, carol })
+      s.push(community_contract, name{"netlink"}, founder, asset(0, other_symbol), founder, account);
+    s.push(token_contract, name{"issue"}, founder, bob, asset(300000, community_symbol), std::string("funds"));
+
+    // More orders on the seller in the other community than a sale looks at, all at a better price
+    for (size_t i = 0; i < max_order_matches; i++)
+      s.push(community_contract, name{"newbuyorder"}, bob, bob, carol, asset(500000, other_symbol), uint64_t(1));
+
+    // The best order can't be paid by its buyer, the next one can
+    s.push(community_contract, name{"newbuyorder"}, mallory, mallory, carol, asset(200000, community_symbol), uint64_t(1));
+    s.push(community_contract, name{"newbuyorder"}, bob, bob, carol, asset(150000, community_symbol), uint64_t(1));
+
+    s.push(community_contract, name{"createsale"}, carol, carol, std::string("Bike"), std::string(""),
+           asset(150000, community_symbol), std::string(""), uint8_t(1), uint64_t(2));
+    s.expect(s.has_row(name{"orderfills"}, 0) && s.row<bespiral::order_fill>(name{"orderfills"}, 0).buyer == bob,
+             "the orders of the other community don't use up the matches of the sale");
+    s.expect(!s.has_row(name{"orderfills"}, 1), "the order its buyer can't pay isn't filled");
+    s.expect(s.has_row(name{"buyorders"}, 0, orders), "the order its buyer can't pay is kept");
+    s.expect(s.has_row(name{"buyorders"}, max_order_matches - 1, other_orders), "the other community's orders are untouched");
+    s.expect(s.row<bespiral::sale>(name{"sale"}, 1).units == 1, "the unit nobody could pay stays on sale");
+
+    // Once the buyer has the funds, restocking fills the order that waited
+    s.push(token_contract, name{"issue"}, founder, mallory, asset(300000, community_symbol), std::string("funds"));
+    s.push(community_contract, name{"updatesale"}, carol, uint64_t(1), std::string("Bike"), std::string(""),
+           asset(150000, community_symbol), std::string(""), uint8_t(1), uint64_t(1));
+    s.expect(s.has_row(name{"orderfills"}, 1) && s.row<bespiral::order_fill>(name{"orderfills"}, 1).buyer == mallory,
+             "the order that waited is filled");
+
+    // Orders are found in the community they were placed in
+    s.push_fails("Can't find any buy order", community_contract, name{"cancelorder"}, bob, community_symbol, uint64_t(2));
+    s.push(community_contract, name{"cancelorder"}, bob, other_symbol, uint64_t(2));
+    s.expect(!s.has_row(name{"buyorders"}, 2, other_orders), "the cancelled order is gone");
+  }
+
+  // Referral paths of a network written before they existed, before and after `netpaths`
+  void legacy_referral_paths(scenario& s) {
+    const name alice{"alice"}, bob{"bob"}, carol{"carol"}, dave{"dave"};
+    s.member(alice);
+    s.native().create_account(bob);
+    s.push(community_contract, name{"netlink"}, alice, asset(0, community_symbol), alice, bob);
+
+    // founder -> alice -> bob, without subtree sizes or ancestors
+    s.make_legacy(name{"network"}, 32);
+
+    // Joining under a legacy member follows the inviters and counts on every one of them
+    s.native().create_account(carol);
+    s.push(community_contract, name{"netlink"}, bob, asset(0, community_symbol), bob, carol);
+    auto carol_row = s.member_row(carol);
+    s.expect(carol_row.has_ancestors() && carol_row.ancestors.value() == std::vector<name>{ bob, alice, founder },
+             "the new member gets the path through its legacy inviters");
+    s.expect(!s.member_row(bob).has_ancestors() && !s.member_row(alice).has_ancestors(),
+             "legacy inviters stay unindexed after their subtree is counted");
+
+    s.run_job(name{"netpaths"}, 0, 1);
+    s.expect(s.member_row(alice).ancestors.value() == std::vector<name>{ founder }, "netpaths sets the path of alice");
+    s.expect(s.member_row(bob).ancestors.value() == std::vector<name>{ alice, founder }, "netpaths sets the path of bob");
+    s.expect(s.member_row(founder).subtree_size.value() == 3, "founder counts alice, bob and carol");
+    s.expect(s.member_row(alice).subtree_size.value() == 2, "alice counts bob and carol");
+    s.expect(s.member_row(bob).subtree_size.value() == 1, "bob counts carol");
+
+    // Joining after the job reads the indexed paths
+    s.native().create_account(dave);
+    s.push(community_contract, name{"netlink"}, carol, asset(0, community_symbol), carol, dave);
+    s.expect(s.member_row(dave).ancestors.value() == std::vector<name>{ carol, bob, alice, founder },
+             "members joining after netpaths get the full path");
+    s.expect(s.member_row(founder).subtree_size.value() == 4 && s.member_row(alice).subtree_size.value() == 3,
+             "members joining after netpaths count on every ancestor");
+  }
+
+  // Expired actions stay on the active index until closeactions completes them
+  void expired_action_waits_for_close(scenario& s) {
+    const name bob{"bob"};
+    s.member(bob);
+
+    uint64_t deadline = s.native().time() + 100;
+    s.push(community_contract, name{"newobjective"}, founder,
+           asset(0, community_symbol), std::string("Objective"), founder);
+    for (uint64_t action_deadline : { deadline, uint64_t(0) }) {
+      s.push(community_contract, name{"upsertaction"}, founder,
+             uint64_t(0), uint64_t(1), std::string("Action"),
+             asset(10, community_symbol), asset(0, community_symbol), action_deadline,
+             uint64_t(5), uint64_t(5), uint64_t(0), std::string("automatic"),
+             std::string(""), uint8_t(0), founder, uint64_t(0));
+    }
+    s.expect(s.has_row(name{"activeacts"}, 1) && s.has_row(name{"activeacts"}, 2), "both actions are indexed");
+
+    // Writing to an expired action doesn't drop it from the index
+    s.native().advance_time(200);
+    s.push(community_contract, name{"verifyaction"}, founder, uint64_t(1), bob, founder);
+    s.expect(s.has_row(name{"activeacts"}, 1), "the expired action stays indexed after a write");
+    s.expect(s.row<bespiral::action>(name{"action"}, 1).is_completed == 0, "the write doesn't complete it");
+
+    s.push(community_contract, name{"closeactions"}, founder, community_symbol, uint64_t(10));
+    s.expect(s.row<bespiral::action>(name{"action"}, 1).is_completed == 1, "closeactions completes the expired action");
+    s.expect(!s.has_row(name{"activeacts"}, 1), "closeactions drops it from the index");
+    s.expect(s.row<bespiral::action>(name{"action"}, 2).is_completed == 0 && s.has_row(name{"activeacts"}, 2),
+             "the action without deadline stays open");
+  }
+
+  // reindexclaim counts the claims from before the open claims counters, and only those
+  void reindex_counts_legacy_claims_once(scenario& s) {
+    const name bob{"bob"}, carol{"carol"};
+    for (auto account : { bob, carol, name{"valone"}, name{"valtwo"} })
+      s.member(account);
+
+    s.push(community_contract, name{"newobjective"}, founder,
+           asset(0, community_symbol), std::string("Objective"), founder);
+    s.push(community_contract, name{"upsertaction"}, founder,
+           uint64_t(0), uint64_t(1), std::string("Action"),
+           asset(10, community_symbol), asset(1, community_symbol), uint64_t(0),
+           uint64_t(0), uint64_t(0), uint64_t(2), std::string("claimable"),
+           std::string("valone-valtwo"), uint8_t(0), founder, uint64_t(0));
+
+    // Two claims opened before the counters existed
+    s.push(community_contract, name{"claimaction"}, bob, uint64_t(1), bob);
+    s.push(community_contract, name{"claimaction"}, bob, uint64_t(1), bob);
+    s.clear_table(name{"openclaims"});
+    s.make_legacy(name{"indexes"}, 32);
+
+    // Opened after the upgrade but before the job is queued, it counts itself
+    s.push(community_contract, name{"claimaction"}, carol, uint64_t(1), carol);
+    s.expect(s.open_claims(carol, 1) == 1, "a new claim is counted when opened");
+
+    s.push_fails("argument must be 0", community_contract, name{"addjob"}, community_contract, name{"reindexclaim"}, uint64_t(3));
+    s.run_job(name{"reindexclaim"}, 0, 1);
+    s.expect(s.open_claims(bob, 1) == 2, "the job counts the legacy claims");
+    s.expect(s.open_claims(carol, 1) == 1, "the job doesn't count the claim opened after the upgrade again");
+  }
+
+  // `reclaim` stops where its budget runs out and picks up there, and releasing the open claims
+  // of a deleted action still updates the aggregates
+  void reclaim_resumes_within_budget(scenario& s) {
+    const name bob{"bob"};
+    for (auto account : { bob, name{"valone"}, name{"valtwo"} })
+      s.member(account);
+
+    s.push(community_contract, name{"newobjective"}, founder,
+           asset(0, community_symbol), std::string("Objective"), founder);
+    for (int i = 0; i < 2; i++)
+      s.push(community_contract, name{"upsertaction"}, founder,
+             uint64_t(0), uint64_t(1), std::string("Action"),
+             asset(10, community_symbol), asset(1, community_symbol), uint64_t(0),
+             uint64_t(0), uint64_t(0), uint64_t(2), std::string("claimable"),
+             std::string("valone-valtwo"), uint8_t(0), founder, uint64_t(0));
+
+    // Claim 1 is verified with two checks, claim 2 stays open, claim 3 is left open by a deleted action
+    s.push(community_contract, name{"claimaction"}, bob, uint64_t(1), bob);
+    s.push(community_contract, name{"claimaction"}, bob, uint64_t(1), bob);
+    s.push(community_contract, name{"claimaction"}, bob, uint64_t(2), bob);
+    s.push(community_contract, name{"verifyclaim"}, name{"valone"}, uint64_t(1), name{"valone"}, uint8_t(1));
+    s.push(community_contract, name{"verifyclaim"}, name{"valtwo"}, uint64_t(1), name{"valtwo"}, uint8_t(1));
+    s.push(community_contract, name{"deleteact"}, community_contract, uint64_t(2));
+    s.expect(s.row<bespiral::aggregate>(name{"aggregates"}, community_symbol.raw()).open_claims == 2, "two claims are open");
+
+    s.push_fails("missing authority of bes.cmm", community_contract, name{"reclaim"}, bob, uint64_t(1));
+    s.push(community_contract, name{"reclaim"}, community_contract, uint64_t(1));
+    s.expect(s.has_row(name{"claim"}, 1) && !s.has_row(name{"check"}, 0) && s.has_row(name{"check"}, 1),
+             "one row of budget erases one check and keeps the claim");
+
+    auto validators_left = [&] {
+      const auto* rows = s.native().find_table(community_contract.value, 2, name{"validator"}.value);
+      return rows != nullptr && !rows->empty();
+    };
+    int calls = 1;
+    for (; calls < 20 && validators_left(); calls++)
+      s.push(community_contract, name{"reclaim"}, community_contract, uint64_t(1));
+    // One row per call: two checks, three claims, the scopes of actions 0 and 1, two validators
+    s.expect(calls == 9, "every call resumes where the last one stopped");
+
+    s.expect(!s.has_row(name{"claim"}, 1) && !s.has_row(name{"check"}, 1), "the verified claim and its checks are gone");
+    s.expect(s.has_row(name{"claim"}, 2), "the claim that can still be verified is kept");
+    s.expect(!s.has_row(name{"claim"}, 3), "the claim of the deleted action is gone");
+    s.expect(s.row<bespiral::claim_summary>(name{"claimsummary"}, 1).verified_claims == 1, "the verified claim is summed up");
+    s.expect(s.open_claims(bob, 2) == 0, "the claim of the deleted action is released");
+    s.expect(s.row<bespiral::aggregate>(name{"aggregates"}, community_symbol.raw()).open_claims == 1,
+             "the claim of the deleted action left the open claims of the aggregates");
+  }
+
+  // Exported pages stay under the inline action size limit and import back into the same rows
+  void exported_rows_import_back(scenario& s) {
+    const name bob{"bob"};
+    s.member(bob);
+
+    const std::string text(250, 'x');
+    for (int i = 0; i < 30; i++)
+      s.push(community_contract, name{"createsale"}, bob, bob, text, text + std::to_string(i),
+             asset(100, community_symbol), std::string(""), uint8_t(0), uint64_t(0));
+
+    auto rows_of = [&](name table) {
+      std::map<uint64_t, std::vector<char>> rows;
+      if (const auto* found = s.native().find_table(community_contract.value, community_contract.value, table.value))
+        for (const auto& r : *found) rows[r.first] = r.second.data;
+      return rows;
+    };
+    auto exported = rows_of(name{"sale"});
+
+    std::vector<bulk::packed_rows> pages;
+    uint64_t from_id = 0;
+    bool pages_fit = true;
+    do {
+      s.push(community_contract, name{"exportrows"}, community_contract, name{"sale"}, community_contract.value, from_id, uint64_t(1000));
+      if (s.native().executed().back().name != name{"rowspage"}) break;
+      auto page = eosio::unpack<rows_page>(s.native().executed().back().data);
+      // The cap counts each row with its size prefix, the row count prefix is one byte more
+      pages_fit = pages_fit && eosio::pack_size(page.rows) <= bulk::max_page_bytes + 1;
+      pages.push_back(page.rows);
+      from_id = page.next_id;
+    } while (from_id != 0 && pages.size() < 30);
+    s.expect(pages.size() > 1, "rows of 500 bytes don't fit a single page");
+    s.expect(pages_fit, "every page stays under the byte cap");
+
+    s.clear_table(name{"sale"});
+    for (const auto& rows : pages)
+      s.push(community_contract, name{"importrows"}, community_contract, name{"sale"}, community_contract.value, rows);
+    s.expect(rows_of(name{"sale"}) == exported, "the imported rows are the exported ones");
+    s.push_fails("Row already exists", community_contract, name{"importrows"}, community_contract,
+                 name{"sale"}, community_contract.value, pages.front());
+  }
+
+  // The recent transfers ring is paid by its owner, keeps its size and overwrites the oldest entry
+  void recent_ring_wraps_around(scenario& s) {
+    const name bob{"bob"}, carol{"carol"};
+    const uint8_t ring_size = 20; // `recent_ring_size` of the token contract
+    for (auto account : { bob, carol })
+      s.member(account);
+
+    auto ring_row = [&]() -> const chain::row* {
+      const auto* rows = s.native().find_table(token_contract.value, bob.value, name{"recent"}.value);
+      if (rows == nullptr) return nullptr;
+      auto found = rows->find(community_symbol.code().raw());
+      return found == rows->end() ? nullptr : &found->second;
+    };
+
+    s.push_fails("missing authority of bob", token_contract, name{"keeprecent"}, carol, bob, community_symbol, true);
+    s.push(token_contract, name{"keeprecent"}, bob, bob, community_symbol, true);
+    s.expect(ring_row() != nullptr && ring_row()->payer == bob.value, "the owner pays for the ring");
+    size_t size = ring_row() ? ring_row()->data.size() : 0;
+
+    for (int64_t amount = 1; amount <= 25; amount++)
+      s.push(token_contract, name{"transfer"}, carol, carol, bob, asset(amount, community_symbol), std::string("memo"));
+
+    s.expect(ring_row() != nullptr && ring_row()->payer == bob.value && ring_row()->data.size() == size,
+             "transfers signed by others overwrite the ring in place, still paid by its owner");
+    if (ring_row() == nullptr) return;
+    auto ring = eosio::unpack<recent_ring>(ring_row()->data);
+    s.expect(ring.transfers.size() == ring_size && ring.next == 25 % ring_size, "next wraps around");
+    s.expect(ring.transfers[(ring.next + ring_size - 1) % ring_size].amount == 25 && ring.transfers[ring.next].amount == 6,
+             "the newest entry is right before next and the oldest at next");
+    s.expect(ring.transfers[ring.next].counterparty == carol, "entries keep the counterparty");
+  }
+
+  // `initaccs` walks the members of the token community only, resuming at the next one each call
+  void init_accounts_walks_the_community(scenario& s) {
+    const name bob{"bob"}, carol{"carol"}, erin{"erin"}, frank{"frank"};
+    const symbol other_symbol{"OTH", 4};
+    for (auto account : { bob, carol })
+      s.member(account);
+
+    s.push(community_contract, name{"create"}, founder,
+           asset(0, other_symbol), founder, std::string("logo"), std::string("Other"),
+           std::string("Another community"), asset(0, other_symbol), asset(0, other_symbol));
+    s.push(token_contract, name{"create"}, founder,
+           founder, asset(1000000000, other_symbol), asset(-100000, other_symbol), std::string("mcc"));
+    for (auto account : { erin, frank }) {
+      s.native().create_account(account);
+      s.push(community_contract, name{"netlink"}, founder, asset(0, other_symbol), founder, account);
+    }
+
+    auto has_balance = [&](name owner) {
+      return s.native().get_row(token_contract, owner.value, name{"accounts"}, community_symbol.code().raw()) != nullptr;
+    };
+    s.clear_table(name{"accounts"}, token_contract);
+
+    auto job = s.run_job(name{"initaccs"}, community_symbol.raw(), 1, token_contract);
+    s.expect(job.processed == 3, "the job visits the three members of the community and no other network row");
+    s.expect(has_balance(founder) && has_balance(bob) && has_balance(carol), "every member gets a balance");
+    s.expect(!has_balance(erin) && !has_balance(frank), "members of other communities get none");
+  }
+
+  // `rebuildagg` recomputes in slices the counters the actions keep up to date, summaries included
+  void aggregates_rebuild_to_live_counts(scenario& s) {
+    const name bob{"bob"};
+    for (auto account : { bob, name{"valone"}, name{"valtwo"} })
+      s.member(account);
+
+    s.push(community_contract, name{"newobjective"}, founder,
+           asset(0, community_symbol), std::string("Objective"), founder);
+    s.push(community_contract, name{"upsertaction"}, founder,
+           uint64_t(0), uint64_t(1), std::string("Action"),
+           asset(10, community_symbol), asset(1, community_symbol), uint64_t(0),
+           uint64_t(0), uint64_t(0), uint64_t(2), std::string("claimable"),
+           std::string("valone-valtwo"), uint8_t(0), founder, uint64_t(0));
+    s.push(community_contract, name{"claimaction"}, bob, uint64_t(1), bob);
+    s.push(community_contract, name{"claimaction"}, bob, uint64_t(1), bob);
+    s.push(community_contract, name{"verifyclaim"}, name{"valone"}, uint64_t(1), name{"valone"}, uint8_t(1));
+    s.push(community_contract, name{"verifyclaim"}, name{"valtwo"}, uint64_t(1), name{"valtwo"}, uint8_t(1));
+    for (int i = 0; i < 2; i++)
+      s.push(community_contract, name{"createsale"}, bob, bob, std::string("Bread"), std::string(""),
+             asset(100, community_symbol), std::string(""), uint8_t(0), uint64_t(0));
+    s.push(community_contract, name{"deletesale"}, bob, uint64_t(1));
+
+    // The verified claim is only left on its summary
+    s.push(community_contract, name{"reclaim"}, community_contract, uint64_t(100));
+    s.expect(!s.has_row(name{"claim"}, 1), "the verified claim was reclaimed");
+
+    auto live = s.row<bespiral::aggregate>(name{"aggregates"}, community_symbol.raw());
+    s.expect(live.members == 4 && live.objectives == 1 && live.open_claims == 1 && live.verified_claims == 1
+             && live.active_sales == 1 && live.reward_volume.amount == 10, "the actions keep the counters");
+
+    s.clear_table(name{"aggregates"});
+    s.push(community_contract, name{"rebuildagg"}, community_contract, community_symbol, uint64_t(2));
+    s.expect(!s.has_row(name{"aggregates"}, community_symbol.raw()), "the counters are only written once the rebuild is done");
+
+    for (int calls = 0; calls < 50 && s.has_row(name{"aggcursor"}, community_symbol.raw()); calls++)
+      s.push(community_contract, name{"rebuildagg"}, community_contract, community_symbol, uint64_t(2));
+    s.expect(!s.has_row(name{"aggcursor"}, community_symbol.raw()), "the rebuild finishes");
+
+    auto rebuilt = s.row<bespiral::aggregate>(name{"aggregates"}, community_symbol.raw());
+    s.expect(rebuilt.members == live.members && rebuilt.objectives == live.objectives
+             && rebuilt.open_claims == live.open_claims && rebuilt.verified_claims == live.verified_claims
+             && rebuilt.active_sales == live.active_sales && rebuilt.reward_volume == live.reward_volume,
+             "the rebuilt counters are the live ones");
+  }
+
+  // Daily activity buckets of a token are reused once the ring wraps around, so RAM stays constant
+  void daily_ring_rolls_over(scenario& s) {
+    const name bob{"bob"}, carol{"carol"};
+    const uint32_t ring_size = 90; // `daily_ring_size` of the token contract
+    for (auto account : { bob, carol })
+      s.member(account);
+
+    const uint64_t scope = community_symbol.code().raw();
+    auto bucket = [&](uint32_t day) {
+      const auto* row = s.native().get_row(token_contract, scope, name{"daily"}, day % ring_size);
+      return row ? eosio::unpack<daily_bucket>(*row) : daily_bucket{};
+    };
+    auto buckets = [&] {
+      const auto* rows = s.native().find_table(token_contract.value, scope, name{"daily"}.value);
+      return rows ? rows->size() : 0;
+    };
+
+    const uint32_t today = s.native().time() / 86400;
+    auto before = bucket(today);
+    s.push(token_contract, name{"issue"}, founder, bob, asset(5000, community_symbol), std::string("funds"));
+    s.push(token_contract, name{"transfer"}, bob, bob, carol, asset(100, community_symbol), std::string("memo"));
+    // Issued tokens reach bob through a transfer from the issuer, which counts as well
+    auto first = bucket(today);
+    s.expect(first.day == today && first.issued.amount == before.issued.amount + 5000
+             && first.transfers == before.transfers + 2
+             && first.transfer_volume.amount == before.transfer_volume.amount + 5100,
+             "the day's bucket adds up the issue and the transfers");
+
+    s.native().advance_time(86400);
+    s.push(token_contract, name{"transfer"}, bob, bob, carol, asset(7, community_symbol), std::string("memo"));
+    auto second = bucket(today + 1);
+    s.expect(second.day == today + 1 && second.transfers == 1 && second.transfer_volume.amount == 7,
+             "the next day starts a bucket of its own");
+    s.expect(bucket(today).day == today && bucket(today).issued.amount == first.issued.amount, "the previous day is kept");
+
+    // `ring_size` days later the first day's slot starts over
+    s.native().advance_time((ring_size - 1) * 86400);
+    size_t kept = buckets();
+    s.push(token_contract, name{"transfer"}, bob, bob, carol, asset(3, community_symbol), std::string("memo"));
+    auto reused = bucket(today);
+    s.expect(reused.day == today + ring_size && reused.transfers == 1 && reused.transfer_volume.amount == 3
+             && reused.issued.amount == 0, "the oldest bucket is reset for the new day");
+    s.expect(buckets() == kept, "wrapping around adds no row");
+  }
+
+  // Sales sharing an image URL hold one blob, counted by reference and erased with the last one
+  void shared_images_are_counted(scenario& s) {
+    const name bob{"bob"};
+    s.member(bob);
+
+    const std::string image = "https://images.example.com/a-long-image-url-many-sales-share.png";
+    const std::string description(200, 'd');
+    for (int i = 0; i < 3; i++)
+      s.push(community_contract, name{"createsale"}, bob, bob, std::string("Bread"), description,
+             asset(100, community_symbol), image, uint8_t(0), uint64_t(0));
+
+    auto first = s.row<bespiral::sale>(name{"sale"}, 1);
+    uint64_t handle = first.image_handle.value_or(0);
+    s.expect(first.image.empty() && handle != 0, "the image is moved to a blob");
+    s.expect(first.description == description && first.description_handle.value_or(0) == 0,
+             "descriptions stay inline, long or not");
+    s.expect(s.row<bespiral::sale>(name{"sale"}, 3).image_handle.value_or(0) == handle, "the sales share one blob");
+
+    auto refs = [&] { return s.has_row(name{"blobs"}, handle) ? s.row<bespiral::blob>(name{"blobs"}, handle).refs : 0; };
+    s.expect(refs() == 3 && s.row<bespiral::blob>(name{"blobs"}, handle).data == image, "the blob counts every sale");
+
+    s.push(community_contract, name{"deletesale"}, bob, uint64_t(1));
+    s.expect(refs() == 2, "deleting a sale releases its reference");
+
+    s.push(community_contract, name{"updatesale"}, bob, uint64_t(2), std::string("Bread"), description,
+           asset(100, community_symbol), image, uint8_t(0), uint64_t(0));
+    s.expect(refs() == 2, "keeping the same image keeps the count");
+
+    for (uint64_t id : { 2, 3 })
+      s.push(community_contract, name{"updatesale"}, bob, id, std::string("Bread"), description,
+             asset(100, community_symbol), std::string("short"), uint8_t(0), uint64_t(0));
+    s.expect(!s.has_row(name{"blobs"}, handle), "the blob is erased with its last reference");
+    s.expect(s.row<bespiral::sale>(name{"sale"}, 2).image == "short", "short images stay inline");
+  }
+
+  // `verifyclaims` applies a review session in order, all or nothing, with one reward issue
+  void verifyclaims_batches_a_session(scenario& s) {
+    const name bob{"bob"}, valone{"valone"}, valtwo{"valtwo"};
+    for (auto account : { bob, valone, valtwo })
+      s.member(account);
+
+    s.push(community_contract, name{"newobjective"}, founder,
+           asset(0, community_symbol), std::string("Objective"), founder);
+    for (int i = 0; i < 2; i++)
+      s.push(community_contract, name{"upsertaction"}, founder,
+             uint64_t(0), uint64_t(1), std::string("Action"),
+             asset(10, community_symbol), asset(1, community_symbol), uint64_t(0),
+             uint64_t(0), uint64_t(0), uint64_t(2), std::string("claimable"),
+             std::string("valone-valtwo"), uint8_t(0), founder, uint64_t(0));
+    s.push(community_contract, name{"claimaction"}, bob, uint64_t(1), bob);
+    s.push(community_contract, name{"claimaction"}, bob, uint64_t(1), bob);
+    s.push(community_contract, name{"claimaction"}, bob, uint64_t(2), bob);
+
+    typedef std::vector<bespiral::claim_vote> votes;
+    s.push_fails("missing authority of valone", community_contract, name{"verifyclaims"}, bob, valone, votes{ { 1, 1 } });
+
+    int64_t valone_before = s.balance(valone), bob_before = s.balance(bob);
+    s.push(community_contract, name{"verifyclaims"}, valone, valone, votes{ { 1, 1 }, { 2, 0 }, { 3, 1 } });
+    int issues = 0;
+    for (const auto& act : s.native().executed())
+      if (act.name == name{"issue"} && eosio::unpack<issue_data>(act.data).to == valone) issues++;
+    s.expect(issues == 1, "the rewards of a session over two actions are sent in one issue");
+    s.expect(s.balance(valone) == valone_before + 3, "every vote is rewarded");
+    s.expect(s.row<bespiral::claim>(name{"claim"}, 2).was_rejected(), "a no vote the validators left can't outweigh rejects the claim");
+
+    // A vote that fails undoes the whole session, even the vote that verified the claim
+    s.push_fails("already verified", community_contract, name{"verifyclaims"}, valtwo, valtwo, votes{ { 1, 1 }, { 1, 1 } });
+    s.expect(s.row<bespiral::claim>(name{"claim"}, 1).is_open(), "the votes before the failed one are undone");
+
+    s.push(community_contract, name{"verifyclaims"}, valtwo, valtwo, votes{ { 1, 1 }, { 3, 1 } });
+    s.expect(s.row<bespiral::claim>(name{"claim"}, 1).is_verified == 1 && s.row<bespiral::claim>(name{"claim"}, 3).is_verified == 1,
+             "the second validator's session verifies both claims");
+    s.expect(s.balance(bob) == bob_before + 20, "the maker is rewarded for each verified claim");
+  }
+
+  // A `delobjective` job erases an objective with its actions, validators, claims and checks in
+  // slices, taking them out of the aggregates, and leaves the other objectives alone
+  void objective_teardown_erases_its_rows(scenario& s) {
+    const name bob{"bob"};
+    for (auto account : { bob, name{"valone"}, name{"valtwo"} })
+      s.member(account);
+
+    for (int i = 0; i < 2; i++)
+      s.push(community_contract, name{"newobjective"}, founder,
+             asset(0, community_symbol), std::string("Objective"), founder);
+    for (uint64_t objective_id : { 1, 2 })
+      s.push(community_contract, name{"upsertaction"}, founder,
+             uint64_t(0), objective_id, std::string("Action"),
+             asset(10, community_symbol), asset(1, community_symbol), uint64_t(0),
+             uint64_t(0), uint64_t(0), uint64_t(2), std::string("claimable"),
+             std::string("valone-valtwo"), uint8_t(0), founder, uint64_t(0));
+
+    // Claim 1 is verified, claim 2 is open with one check, claim 3 belongs to the other objective
+    s.push(community_contract, name{"claimaction"}, bob, uint64_t(1), bob);
+    s.push(community_contract, name{"verifyclaim"}, name{"valone"}, uint64_t(1), name{"valone"}, uint8_t(1));
+    s.push(community_contract, name{"verifyclaim"}, name{"valtwo"}, uint64_t(1), name{"valtwo"}, uint8_t(1));
+    s.push(community_contract, name{"claimaction"}, bob, uint64_t(1), bob);
+    s.push(community_contract, name{"verifyclaim"}, name{"valone"}, uint64_t(2), name{"valone"}, uint8_t(1));
+    s.push(community_contract, name{"claimaction"}, bob, uint64_t(2), bob);
+
+    s.push_fails("Can't find objective", community_contract, name{"addjob"}, community_contract, name{"delobjective"}, uint64_t(9));
+    s.push(community_contract, name{"addjob"}, community_contract, name{"delobjective"}, uint64_t(1));
+    s.push(community_contract, name{"runjob"}, community_contract, uint64_t(0), uint64_t(1));
+    s.push_fails("already completed", community_contract, name{"claimaction"}, bob, uint64_t(1), bob);
+
+    int calls = 1;
+    for (; calls < 50 && !s.row<bespiral::job>(name{"jobs"}, 0).is_done; calls++)
+      s.push(community_contract, name{"runjob"}, community_contract, uint64_t(0), uint64_t(1));
+    s.expect(s.row<bespiral::job>(name{"jobs"}, 0).is_done && calls > 5, "the teardown takes one row per call");
+
+    auto validators_of = [&](uint64_t action_id) {
+      const auto* rows = s.native().find_table(community_contract.value, action_id, name{"validator"}.value);
+      return rows ? rows->size() : 0;
+    };
+    s.expect(!s.has_row(name{"objective"}, 1) && !s.has_row(name{"action"}, 1) && validators_of(1) == 0,
+             "the objective, its action and its validators are gone");
+    s.expect(!s.has_row(name{"claim"}, 1) && !s.has_row(name{"claim"}, 2) && !s.has_row(name{"check"}, 0)
+             && !s.has_row(name{"check"}, 1) && !s.has_row(name{"check"}, 2), "its claims and checks are gone");
+    s.expect(s.open_claims(bob, 1) == 0, "the open claim is released");
+    s.expect(s.has_row(name{"objective"}, 2) && s.has_row(name{"action"}, 2) && validators_of(2) == 2
+             && s.has_row(name{"claim"}, 3), "the other objective is untouched");
+
+    auto aggregate = s.row<bespiral::aggregate>(name{"aggregates"}, community_symbol.raw());
+    s.expect(aggregate.objectives == 1 && aggregate.open_claims == 1 && aggregate.verified_claims == 0
+             && aggregate.reward_volume.amount == 0, "the aggregates only count the other objective");
+  }
+
+  // Balances at the opening of an epoch are read back from checkpoints saved on the first change
+  void balance_at_epoch_from_checkpoints(scenario& s) {
+    const name bob{"bob"}, carol{"carol"}, dave{"dave"};
+    for (auto account : { bob, carol, dave })
+      s.member(account);
+
+    const uint64_t scope = community_symbol.code().raw();
+    auto checkpoints = [&] {
+      std::vector<checkpoint_row> rows;
+      if (const auto* found = s.native().find_table(token_contract.value, scope, name{"checkpoints"}.value))
+        for (const auto& r : *found) rows.push_back(eosio::unpack<checkpoint_row>(r.second.data));
+      return rows;
+    };
+    // The owner's first checkpoint at `epoch` or later, or the current balance
+    auto balance_at = [&](name owner, uint64_t epoch) {
+      int64_t balance = s.balance(owner);
+      uint64_t found = UINT64_MAX;
+      for (const auto& cp : checkpoints())
+        if (cp.owner == owner && cp.epoch >= epoch && cp.epoch < found) {
+          found = cp.epoch;
+          balance = cp.balance.amount;
+        }
+      return balance;
+    };
+    auto transfer = [&](name from, name to, int64_t amount) {
+      s.push(token_contract, name{"transfer"}, from, from, to, asset(amount, community_symbol), std::string("memo"));
+    };
+
+    s.push(token_contract, name{"issue"}, founder, bob, asset(5000, community_symbol), std::string("funds"));
+    transfer(bob, carol, 100);
+    s.expect(checkpoints().empty(), "nothing is saved before the first epoch");
+
+    s.push_fails("missing authority of founder", token_contract, name{"openepoch"}, bob, community_symbol);
+    s.push(token_contract, name{"openepoch"}, founder, community_symbol);
+    int64_t bob_at_1 = s.balance(bob), carol_at_1 = s.balance(carol);
+
+    transfer(bob, carol, 100);
+    transfer(bob, carol, 100);
+    s.expect(checkpoints().size() == 2, "only the first change of an account in an epoch is saved");
+    s.expect(balance_at(bob, 1) == bob_at_1 && balance_at(carol, 1) == carol_at_1, "the epoch keeps the balances it opened with");
+
+    s.native().advance_time(60);
+    s.push(token_contract, name{"openepoch"}, founder, community_symbol);
+    int64_t bob_at_2 = s.balance(bob);
+    transfer(bob, dave, 50);
+    s.expect(checkpoints().size() == 4, "a new epoch saves the next change again");
+    s.expect(balance_at(bob, 1) == bob_at_1 && balance_at(bob, 2) == bob_at_2 && balance_at(bob, 3) == bob_at_2 - 50,
+             "each epoch reads the balance it opened with");
+    s.expect(balance_at(dave, 2) == 0 && balance_at(carol, 2) == carol_at_1 + 200, "untouched accounts read their current balance");
+  }
+
+  struct named_scenario {
+    const char* name;
+    void (*run)(scenario&);
+  };
+
+  const named_scenario scenarios[] = {
+    { "rejected_claim_is_released", rejected_claim_is_released },
+    { "buy_order_needs_buyer_approval", buy_order_needs_buyer_approval },
+    { "buy_orders_stay_in_their_community", buy_orders_stay_in_their_community },
+    { "legacy_referral_paths", legacy_referral_paths },
+    { "expired_action_waits_for_close", expired_action_waits_for_close },
+    { "reindex_counts_legacy_claims_once", reindex_counts_legacy_claims_once },
+    { "reclaim_resumes_within_budget", reclaim_resumes_within_budget },
+    { "exported_rows_import_back", exported_rows_import_back },
+    { "recent_ring_wraps_around", recent_ring_wraps_around },
+    { "init_accounts_walks_the_community", init_accounts_walks_the_community },
+    { "aggregates_rebuild_to_live_counts", aggregates_rebuild_to_live_counts },
+    { "daily_ring_rolls_over", daily_ring_rolls_over },
+    { "shared_images_are_counted", shared_images_are_counted },
+    { "verifyclaims_batches_a_session", verifyclaims_batches_a_session },
+    { "objective_teardown_erases_its_rows", objective_teardown_erases_its_rows },
+    { "balance_at_epoch_from_checkpoints", balance_at_epoch_from_checkpoints },
+  };
+
+}
+
+int main(int argc, char** argv) {
+  std::vector<std::string> only(argv + 1, argv + argc);
+  int failed = 0;
+
+  for (const auto& sc : scenarios) {
+    if (!only.empty() && std::find(only.begin(), only.end(), sc.name) == only.end())
+      continue;
+
+    std::vector<std::string> failures;
+    try {
+      scenario s(failures);
+      sc.run(s);
+    } catch (const std::exception& e) {
+      failures.push_back(std::string("aborted: ") + e.what());
+    }
+
+    std::printf("%-40s %s\n", sc.name, failures.empty() ? "ok" : "FAILED");
+    for (const auto& f : failures)
+      std::printf("  %s\n", f.c_str());
+    failed += !failures.empty();
+  }
+
+  return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+#include "../utils/utils.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+/**
+   Micro-benchmark of the parsing and formatting helpers in utils/utils.hpp.
+
+   Splits validator lists of growing length and formats integers, reporting the wall time, heap
+   allocations and heap bytes per call. The contracts run with a bump allocator that never gives
+   memory back within an action, so the bytes column is what a list of that length costs.
+   `copying split` is the substr based split the contracts used before, kept for comparison.
+
+   Usage: utilbench [-r reps] [items...]
+*/
+
+namespace {
+
+  uint64_t allocations = 0;
+  uint64_t allocated_bytes = 0;
+
+  std::vector<std::string> copying_split(std::string str, std::string delim) {
+    std::vector<std::string> result;
+    while (str.size()) {
+      auto index = str.find(delim);
+      if (index != std::string::npos) {
+        result.push_back(str.substr(0, index));
+        str = str.substr(index + delim.size());
+        if (str.size() == 0) result.push_back(str);
+      } else {
+        result.push_back(str);
+        str = "";
+      }
+    }
+    return result;
+  }
+
+  // Twelve character account names joined by '-'
+  std::string validator_list(uint64_t items) {
+    std::string list;
+    for (uint64_t i = 0; i < items; i++) {
+      if (i > 0) list += '-';
+      std::string name = "validator";
+      for (uint64_t n = i, d = 0; d < 3; d++, n /= 26)
+        name += char('a' + n % 26);
+      list += name;
+    }
+    return list;
+  }
+
+  volatile uint64_t sink = 0;
+
+  template <typename F>
+  void measure(const char* what, uint64_t items, uint32_t reps, F&& f) {
+    uint64_t start_allocations = allocations, start_bytes = allocated_bytes;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < reps; i++)
+      sink += f();
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::printf("%8llu  %-16s %10.3f %10.1f %12.1f\n", (unsigned long long)items, what, elapsed.count() / reps,
+                double(allocations - start_allocations) / reps, double(allocated_bytes - start_bytes) / reps);
+  }
+
+} // namespace
+
+void* operator new(std::size_t size) {
+  allocations++;
+  allocated_bytes += size;
+  if (void* p = std::malloc(size ? size : 1)) return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+int main(int argc, char** argv) {
+  uint32_t reps = 10000;
+  std::vector<uint64_t> items;
+
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+      reps = std::strtoul(argv[++i], nullptr, 10);
+    else
+      items.push_back(std::strtoull(argv[i], nullptr, 10));
+  }
+
+  if (items.empty())
+    items = { 3, 16, 128, 1024 };
+
+  if (reps == 0) {
+    std::fprintf(stderr, "reps must be greater than 0\n");
+    return 1;
+  }
+
+  std::printf("%8s  %-16s %10s %10s %12s\n", "items", "helper", "us/call", "allocs", "bytes");
+
+  for (auto n : items) {
+    std::string list = validator_list(n);
+
+    measure("copying split", n, reps, [&] { return copying_split(list, "-").size(); });
+    measure("split", n, reps, [&] { return split(list, "-").size(); });
+    measure("for_each_token", n, reps, [&] {
+        uint64_t valid = 0;
+        for_each_token(list, "-", [&](std::string_view token) { valid += is_valid_name(token); });
+        return valid;
+      });
+  }
+
+  uint64_t value = 18446744073709551615ull;
+  measure("std::to_string", 20, reps, [&] { return std::to_string(value).size(); });
+  measure("uint64_to_str", 20, reps, [&] { return uint64_to_str(value).size(); });
+  measure("format_uint64", 20, reps, [&] {
+      char buffer[uint64_digits];
+      return format_uint64(buffer, value).size();
+    });
+
+  return 0;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <eosiolib/eosio.hpp>
+
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+/**
+   Action argument decoding without copies, for the actions called the most.
+
+   `EOSIO_DISPATCH` unpacks every argument into an owned value, so a memo that is only checked
+   for its length still gets copied to the heap. `args::execute` reads the action data once and
+   decodes it in place: fixed size arguments are read as usual and `std::string_view` arguments
+   point into the action data, after checking that the whole text is there. Views only live for
+   the duration of the action, anything kept must be copied.
+
+   Actions dispatched this way keep their `ACTION` declaration for the ABI and inline sends,
+   forwarding to a member that takes views.
+*/
+namespace args {
+
+  // Action data up to this size is read into a stack buffer, like execute_action does
+  const std::size_t stack_buffer_size = 512;
+
+  template <typename T>
+  T read(eosio::datastream<const char *> &ds) {
+    T value;
+    ds >> value;
+    return value;
+  }
+
+  template <>
+  inline std::string_view read<std::string_view>(eosio::datastream<const char *> &ds) {
+    eosio::unsigned_int size;
+    ds >> size;
+    eosio_assert(size.value <= ds.remaining(), "read");
+
+    std::string_view value(ds.pos(), size.value);
+    ds.skip(size.value);
+    return value;
+  }
+
+  // Runs `func` with the arguments decoded from the current action data
+  template <typename T, typename... Args>
+  void execute(std::uint64_t receiver, std::uint64_t code, void (T::*func)(Args...)) {
+    std::size_t size = action_data_size();
+
+    char small[stack_buffer_size];
+    std::vector<char> large;
+    char *data = small;
+    if (size > stack_buffer_size) {
+      large.resize(size);
+      data = large.data();
+    }
+    if (size > 0) read_action_data(data, size);
+
+    eosio::datastream<const char *> ds(data, size);
+
+    // Braced initialization decodes the arguments in order
+    std::tuple<std::decay_t<Args>...> values{read<std::decay_t<Args>>(ds)...};
+
+    T inst(eosio::name(receiver), eosio::name(code), ds);
+    std::apply([&](auto &... a) { (inst.*func)(a...); }, values);
+  }
+
+  template <typename T>
+  std::size_t packed_size(const T &value) {
+    return eosio::pack_size(value);
+  }
+
+  inline std::size_t packed_size(std::string_view value) {
+    return eosio::pack_size(eosio::unsigned_int(value.size())) + value.size();
+  }
+
+  template <typename T>
+  void write(eosio::datastream<char *> &ds, const T &value) {
+    ds << value;
+  }
+
+  inline void write(eosio::datastream<char *> &ds, std::string_view value) {
+    ds << eosio::unsigned_int(value.size());
+    ds.write(value.data(), value.size());
+  }
+
+  // Packs inline action data, copying the text of views straight into it
+  template <typename... Args>
+  std::vector<char> pack(const Args &... values) {
+    std::vector<char> data((packed_size(values) + ... + 0));
+    eosio::datastream<char *> ds(data.data(), data.size());
+    (write(ds, values), ...);
+    return data;
+  }
+
+} // namespace args
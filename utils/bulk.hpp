@@ -0,0 +1,56 @@
+#pragma once
+
+#include <eosiolib/eosio.hpp>
+
+#include <type_traits>
+#include <vector>
+
+/**
+   Bulk export and import of table rows, used to move a contract state to another chain.
+
+   Rows travel packed exactly as the table stores them, so an exported page can be passed as is
+   to the import action of the same table. Exports go page by page: each one returns the
+   primary key where the next page starts, or 0 once the table is done.
+
+   Pages are sent as inline actions, which EOSIO limits to `max_inline_action_size`, 4 KB by
+   default. A page ends after `max_rows` rows or once its rows reach `max_page_bytes`, whichever
+   comes first, so a large `max_rows` only means fewer calls on tables of small rows. A row
+   bigger than the budget still gets a page of its own, which fails if it exceeds the limit.
+*/
+namespace bulk {
+
+  typedef std::vector<std::vector<char>> packed_rows;
+
+  // Packed rows of a page, leaving room under 4 KB for the other fields of the action
+  const std::size_t max_page_bytes = 3584;
+
+  template <typename Table>
+  std::uint64_t export_page(const Table &table, std::uint64_t from_id, std::uint64_t max_rows, packed_rows &rows) {
+    std::size_t bytes = 0;
+    auto itr = table.lower_bound(from_id);
+    for (; itr != table.end() && rows.size() < max_rows; itr++) {
+      auto data = eosio::pack(*itr);
+      std::size_t size = eosio::pack_size(eosio::unsigned_int(data.size())) + data.size();
+      if (!rows.empty() && bytes + size > max_page_bytes)
+        break;
+
+      bytes += size;
+      rows.push_back(std::move(data));
+    }
+
+    return itr == table.end() ? 0 : itr->primary_key();
+  }
+
+  // Rows are emplaced as they come, the import fails if any of them already exists
+  template <typename Table>
+  void import_page(Table &table, eosio::name payer, const packed_rows &rows) {
+    typedef typename std::decay<decltype(*table.cbegin())>::type row_type;
+
+    for (const auto &data : rows) {
+      auto row = eosio::unpack<row_type>(data);
+      eosio_assert(table.find(row.primary_key()) == table.end(), "Row already exists");
+      table.emplace(payer, [&](auto &r) { r = row; });
+    }
+  }
+
+} // namespace bulk
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <eosiolib/eosio.hpp>
+
+/**
+   Resumable maintenance jobs.
+
+   Each contract keeps a `jobs` table with one row per job: its type, an argument whose meaning
+   depends on the type, the cursor where the next slice starts and how many rows were processed.
+   `runjob(id, max_rows)` processes one slice of at most `max_rows` rows and saves the cursor, so
+   a keeper can drive a job over tables of any size at a predictable cost per transaction.
+
+   Job rows must have the fields id, type, argument, cursor, processed and is_done.
+*/
+namespace jobs {
+
+  // What a step did during one call of runjob
+  struct slice {
+    std::uint64_t cursor; // Where the next slice starts
+    std::uint64_t rows;   // Rows processed by this slice
+    bool done;
+  };
+
+  template <typename Table>
+  std::uint64_t add(Table &table, eosio::name payer, eosio::name type, std::uint64_t argument) {
+    std::uint64_t id = table.available_primary_key();
+    table.emplace(payer, [&](auto &j) {
+                           j.id = id;
+                           j.type = type;
+                           j.argument = argument;
+                           j.cursor = 0;
+                           j.processed = 0;
+                           j.is_done = 0;
+                         });
+    return id;
+  }
+
+  // Runs the next slice of a job, `step(job, max_rows)` does the work and returns a slice
+  template <typename Table, typename Step>
+  void run(Table &table, eosio::name payer, std::uint64_t id, std::uint64_t max_rows, Step &&step) {
+    eosio_assert(max_rows > 0, "max_rows must be greater than 0");
+
+    auto itr = table.find(id);
+    eosio_assert(itr != table.end(), "Can't find job with given id");
+    eosio_assert(!itr->is_done, "Job is already done");
+
+    slice s = step(*itr, max_rows);
+    table.modify(itr, payer, [&](auto &j) {
+                               j.cursor = s.cursor;
+                               j.processed += s.rows;
+                               j.is_done = s.done;
+                             });
+  }
+
+} // namespace jobs
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <eosiolib/print.hpp>
+
+/**
+   Compile-time gated logging and instrumentation.
+
+   Build with -DBESPIRAL_LOG_LEVEL=<level> to enable it:
+
+   0) Default, every macro expands to nothing and its arguments are never evaluated
+   1) BES_LOG_INFO messages
+   2) BES_LOG_DEBUG messages too, plus the row and inline action counters, printed as a
+      summary at the end of every action marked with BES_TRACE_ACTION
+
+   Messages use the `print_f` format, each `%` is replaced by the next argument.
+ */
+#ifndef BESPIRAL_LOG_LEVEL
+#define BESPIRAL_LOG_LEVEL 0
+#endif
+
+#if BESPIRAL_LOG_LEVEL >= 1
+#define BES_LOG_INFO(...) eosio::print_f(__VA_ARGS__)
+#else
+#define BES_LOG_INFO(...) ((void)0)
+#endif
+
+#if BESPIRAL_LOG_LEVEL >= 2
+#define BES_LOG_DEBUG(...) eosio::print_f(__VA_ARGS__)
+#define BES_TRACE_ACTION(action_name) bes_trace::action_summary bes_trace_summary(action_name)
+#define BES_COUNT(counter) (bes_trace::current().counter++)
+#else
+#define BES_LOG_DEBUG(...) ((void)0)
+#define BES_TRACE_ACTION(action_name) ((void)0)
+#define BES_COUNT(counter) ((void)0)
+#endif
+
+#if BESPIRAL_LOG_LEVEL >= 2
+namespace bes_trace {
+
+  struct counters {
+    uint32_t rows_read = 0;     // Rows visited by loops over a table
+    uint32_t rows_written = 0;  // Rows stored, modified or erased
+    uint32_t inline_sends = 0;
+  };
+
+  inline counters &current() {
+    static counters c;
+    return c;
+  }
+
+  // Resets the counters when an action starts and prints them when it returns
+  struct action_summary {
+    const char *name;
+
+    explicit action_summary(const char *action_name) : name(action_name) { current() = counters(); }
+
+    ~action_summary() {
+      const auto &c = current();
+      eosio::print_f("[%] rows read %, rows written %, inline sends %\n",
+                     name, c.rows_read, c.rows_written, c.inline_sends);
+    }
+  };
+
+} // namespace bes_trace
+#endif
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/crypto.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+   Helpers shared by both contracts.
+
+   Parsing works on `std::string_view` and hands out views into the input, so splitting a list
+   costs one vector and no copy of its items. Keep the views only while the input is alive.
+*/
+
+inline uint128_t combine_ids(uint64_t const& x, uint64_t const& y) {
+  uint128_t times = 1;
+  while (times <= y)
+    times *= 10;
+
+  return (x * times) + y;
+}
+
+// Network ids are stored on chain, this must keep giving the same ids
+inline uint64_t gen_uuid(const uint64_t &x, const uint64_t &y) {
+  uint128_t res = combine_ids(x, y);
+  return std::hash<uint128_t>{}(res);
+}
+
+inline uint64_t hash_to_uint64(const eosio::checksum256 &hash) {
+  auto hash_bytes = hash.extract_as_byte_array();
+  uint128_t num = combine_ids(
+      combine_ids(hash_bytes[0], hash_bytes[1]),
+      combine_ids(hash_bytes[2], hash_bytes[3])
+  );
+
+  return std::hash<uint128_t>{}(num);
+}
+
+// Enough room for any uint64_t in decimal
+const std::size_t uint64_digits = 20;
+
+// Writes `value` in decimal at the end of `buffer`, returns a view of the digits
+inline std::string_view format_uint64(char (&buffer)[uint64_digits], uint64_t value) {
+  char *begin = buffer + uint64_digits;
+  do {
+    *--begin = '0' + value % 10;
+    value /= 10;
+  } while (value);
+
+  return std::string_view(begin, buffer + uint64_digits - begin);
+}
+
+inline std::string uint64_to_str(const uint64_t &value) {
+  char buffer[uint64_digits];
+  return std::string(format_uint64(buffer, value));
+}
+
+// Calls `f` with each item of `str` separated by `delim`. Empty items are kept, an empty string has none
+template <typename Lambda>
+void for_each_token(std::string_view str, std::string_view delim, Lambda &&f) {
+  if (str.empty()) return;
+
+  std::size_t start = 0;
+  while (true) {
+    std::size_t index = str.find(delim, start);
+    if (index == std::string_view::npos) {
+      f(str.substr(start));
+      return;
+    }
+    f(str.substr(start, index - start));
+    start = index + delim.size();
+  }
+}
+
+inline std::vector<std::string_view> split(std::string_view str, std::string_view delim) {
+  std::vector<std::string_view> result;
+  for_each_token(str, delim, [&](std::string_view token) { result.push_back(token); });
+  return result;
+}
+
+/*
+  Whether `str` is the text form of a name, the one `eosio::name(str).to_string()` gives back.
+  Unlike the name constructor it never aborts, so callers choose the error message.
+ */
+constexpr bool is_valid_name(std::string_view str) {
+  if (str.empty() || str.size() > 13 || str.back() == '.') return false;
+
+  for (std::size_t i = 0; i < str.size(); i++) {
+    char c = str[i];
+    bool valid = c == '.' || (c >= '1' && c <= '5') || (c >= 'a' && c <= (i == 12 ? 'j' : 'z'));
+    if (!valid) return false;
+  }
+
+  return true;
+}
+
+static_assert(is_valid_name("bespiral") && is_valid_name("bes.cmm") && is_valid_name("a12345.zzzzzj"),
+              "is_valid_name must accept valid names");
+static_assert(!is_valid_name("") && !is_valid_name("Bob") && !is_valid_name("bob.") &&
+              !is_valid_name("a12345.zzzzzk") && !is_valid_name("aaaaaaaaaaaaaa") && !is_valid_name("bob6"),
+              "is_valid_name must reject invalid names");
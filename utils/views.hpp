@@ -0,0 +1,47 @@
+#pragma once
+
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/asset.hpp>
+
+/**
+   Read-only views of rows owned by other BeSpiral contracts.
+
+   multi_index fills a row by reading its fields in order and ignores whatever follows, so a
+   view declaring only the leading fields of a row never decodes the strings stored after them.
+   Field order must match the owner's EOSLIB_SERIALIZE, and the owner checks the field types
+   with static_assert. A view must never be used to write: the trailing fields would be lost.
+
+   Views are versioned. When a row layout changes, add a new version next to the old one.
+*/
+namespace views {
+
+  // bespiral.community `community` rows: symbol and creator, skipping logo, name and description
+  struct community_v1 {
+    eosio::symbol symbol;
+    eosio::name creator;
+
+    std::uint64_t primary_key() const { return symbol.raw(); }
+
+    EOSLIB_SERIALIZE(community_v1, (symbol)(creator));
+  };
+
+  // bespiral.community `network` rows: membership, without the inviter
+  struct network_v1 {
+    std::uint64_t id;
+    eosio::symbol community;
+    eosio::name invited_user;
+
+    std::uint64_t primary_key() const { return id; }
+    std::uint64_t users_by_cmm() const { return community.raw(); }
+
+    EOSLIB_SERIALIZE(network_v1, (id)(community)(invited_user));
+  };
+
+  typedef eosio::multi_index<eosio::name{"community"}, community_v1> communities_v1;
+  // Members of a community are read in id order through the owner's `usersbycmm` index
+  typedef eosio::multi_index<eosio::name{"network"},
+                             network_v1,
+                             eosio::indexed_by<eosio::name{"usersbycmm"},
+                                               eosio::const_mem_fun<network_v1, uint64_t, &network_v1::users_by_cmm>>
+                            > networks_v1;
+}